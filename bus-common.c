@@ -110,6 +110,95 @@ void SyncCPUCommon(const ClownMDEmu* const clownmdemu, SyncCPUState* const sync,
 	}
 }
 
+void ResetM68kIdleLoop(M68kIdleLoop* const idle_loop)
+{
+	idle_loop->tracking = cc_false;
+}
+
+static void BeginM68kIdleLoopIteration(M68kIdleLoop* const idle_loop, const Clown68000_State* const state, const cc_u32f cycle)
+{
+	idle_loop->snapshot = *state;
+	idle_loop->start_cycle = cycle;
+	idle_loop->end_cycle = 0xFFFFFFFF;
+	idle_loop->tracking = cc_true;
+	idle_loop->side_effects = cc_false;
+}
+
+static cc_bool M68kStatesMatch(const Clown68000_State* const state1, const Clown68000_State* const state2)
+{
+	cc_u8f i;
+
+	for (i = 0; i < CC_COUNT_OF(state1->data_registers); ++i)
+		if (state1->data_registers[i] != state2->data_registers[i])
+			return cc_false;
+
+	for (i = 0; i < CC_COUNT_OF(state1->address_registers); ++i)
+		if (state1->address_registers[i] != state2->address_registers[i])
+			return cc_false;
+
+	return state1->program_counter == state2->program_counter && state1->status_register == state2->status_register;
+}
+
+static cc_u32f UpdateM68kIdleLoop(M68kIdleLoop* const idle_loop, const Clown68000_State* const state, const cc_u32f previous_program_counter, const cc_u32f current_cycle, const cc_u32f cycles, const cc_u32f target_cycle)
+{
+	cc_u32f new_cycles = cycles;
+
+	if (idle_loop->tracking && state->program_counter == idle_loop->snapshot.program_counter)
+	{
+		/* An iteration of the loop has completed. If it left the CPU exactly as it found it, and did not do anything
+		   which cannot be repeated, then every iteration until its inputs change will behave identically, so they can
+		   be skipped. Interrupts are only raised between syncs, so the end of the sync is the latest that this can be. */
+		if (!idle_loop->side_effects && M68kStatesMatch(state, &idle_loop->snapshot))
+		{
+			const cc_u32f next_cycle = current_cycle + cycles;
+			const cc_u32f iteration_cycles = next_cycle - idle_loop->start_cycle;
+			const cc_u32f end_cycle = CC_MIN(target_cycle, idle_loop->end_cycle);
+
+			if (end_cycle > next_cycle)
+				new_cycles += (end_cycle - next_cycle) / iteration_cycles * iteration_cycles;
+		}
+
+		BeginM68kIdleLoopIteration(idle_loop, state, current_cycle + new_cycles);
+	}
+	else if (state->program_counter <= previous_program_counter)
+	{
+		/* A backwards branch: this could be the start of a loop. */
+		BeginM68kIdleLoopIteration(idle_loop, state, current_cycle + new_cycles);
+	}
+
+	return new_cycles;
+}
+
+cc_u16f RunM68k(Clown68000_State* const state, const Clown68000_ReadWriteCallbacks* const callbacks, SyncCPUState* const sync, const cc_u32f clock_divisor, const cc_u32f target_cycle, M68kIdleLoop* const idle_loop)
+{
+	const cc_u32f start_cycle = sync->current_cycle;
+	/* The countdown is 16-bit, so leave room for the last instruction to overrun this. */
+	const cc_u32f end_cycle = CC_MIN(target_cycle, start_cycle + 0xF000);
+
+	cc_u32f cycles;
+
+	/* The sync is advanced as instructions are done so that the bus callbacks know what time it is.
+	   Every instruction that begins at or before the end cycle must be done. */
+	do
+	{
+		const cc_u32f previous_program_counter = state->program_counter;
+
+		cycles = clock_divisor * Clown68000_DoCycle(state, callbacks);
+
+		if (idle_loop != NULL)
+			cycles = UpdateM68kIdleLoop(idle_loop, state, previous_program_counter, sync->current_cycle, cycles, end_cycle);
+
+		sync->current_cycle += cycles;
+	} while (sync->current_cycle <= end_cycle);
+
+	cycles = sync->current_cycle - start_cycle;
+
+	/* 'SyncCPUCommon' advances this itself. */
+	sync->current_cycle = start_cycle;
+
+	return cycles;
+}
+
 static void FMCallbackWrapper(const ClownMDEmu* const clownmdemu, cc_s16l* const sample_buffer, const size_t total_frames)
 {
 	FM_OutputSamples(&clownmdemu->fm, sample_buffer, total_frames);
@@ -127,6 +216,11 @@ cc_u8f SyncFM(CPUCallbackUserData* const other_state, const CycleMegaDrive targe
 	return FM_Update(&other_state->clownmdemu->fm, SyncCommon(&other_state->sync.fm, target_cycle.cycle, CLOWNMDEMU_M68K_CLOCK_DIVIDER), GenerateFMAudio, other_state);
 }
 
+void FlushFM(CPUCallbackUserData* const other_state)
+{
+	FM_Flush(&other_state->clownmdemu->fm, GenerateFMAudio, other_state);
+}
+
 static void GeneratePSGAudio(const ClownMDEmu* const clownmdemu, cc_s16l* const sample_buffer, const size_t total_frames)
 {
 	PSG_Update(&clownmdemu->psg, sample_buffer, total_frames);
@@ -17,9 +17,18 @@ typedef struct SyncCPUState
 	cc_u32l *cycle_countdown;
 } SyncCPUState;
 
+/* What the Z80's window into the 68k's address space currently points to. */
+typedef enum Z80BankWindow
+{
+	Z80_BANK_WINDOW_OTHER,
+	Z80_BANK_WINDOW_CARTRIDGE,
+	Z80_BANK_WINDOW_68K_RAM
+} Z80BankWindow;
+
 typedef struct CPUCallbackUserData
 {
 	const ClownMDEmu *clownmdemu;
+	Z80BankWindow z80_bank_window;
 	struct
 	{
 		SyncCPUState m68k;
@@ -43,6 +52,16 @@ typedef struct CycleMegaCD
 	cc_u32f cycle;
 } CycleMegaCD;
 
+/* Detects loops which do nothing but wait for something outside of the CPU to happen, so that they can be skipped. */
+typedef struct M68kIdleLoop
+{
+	Clown68000_State snapshot; /* The CPU's state at the start of the current iteration. */
+	cc_u32f start_cycle;
+	cc_u32f end_cycle; /* The iteration's inputs may change after this point, so it must not be skipped beyond it. */
+	cc_bool tracking;
+	cc_bool side_effects;
+} M68kIdleLoop;
+
 /* TODO: Move this to somewhere more specific. */
 typedef struct IOPortToController_Parameters
 {
@@ -62,7 +81,13 @@ CycleMegaDrive CycleMegaCDToMegaDrive(const ClownMDEmu *clownmdemu, CycleMegaCD
 
 cc_u32f SyncCommon(SyncState *sync, cc_u32f target_cycle, cc_u32f clock_divisor);
 void SyncCPUCommon(const ClownMDEmu *clownmdemu, SyncCPUState *sync, cc_u32f target_cycle, cc_bool cpu_not_running, SyncCPUCommonCallback callback, const void *user_data);
+void ResetM68kIdleLoop(M68kIdleLoop *idle_loop);
+/* Runs a 68000 for as long as it can without going past 'target_cycle', for use by 'SyncCPUCommonCallback' functions.
+   'idle_loop' may be NULL to disable idle loop skipping. Returns the number of cycles done. */
+cc_u16f RunM68k(Clown68000_State *state, const Clown68000_ReadWriteCallbacks *callbacks, SyncCPUState *sync, cc_u32f clock_divisor, cc_u32f target_cycle, M68kIdleLoop *idle_loop);
 cc_u8f SyncFM(CPUCallbackUserData *other_state, CycleMegaDrive target_cycle);
+/* Outputs the audio which 'SyncFM' has deferred. */
+void FlushFM(CPUCallbackUserData *other_state);
 void SyncPSG(CPUCallbackUserData *other_state, CycleMegaDrive target_cycle);
 void SyncPCM(CPUCallbackUserData *other_state, CycleMegaCD target_cycle);
 void SyncCDDA(CPUCallbackUserData *other_state, cc_u32f total_frames);
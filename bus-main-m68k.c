@@ -33,6 +33,37 @@ static cc_bool GetHBlankBit(const ClownMDEmu* const clownmdemu, const CycleMegaD
 	return GetHCounterValue(clownmdemu, target_cycle) > 0xB2;
 }
 
+static CycleMegaDrive GetNextHBlankBitChange(const ClownMDEmu* const clownmdemu, const CycleMegaDrive current_cycle)
+{
+	/* This mirrors the logic of the above two functions. */
+	const cc_u32f cycles_per_scanline = GetMegaDriveCyclesPerFrame(clownmdemu).cycle / GetTelevisionVerticalResolution(clownmdemu);
+	const cc_u32f cycle_within_scanline = current_cycle.cycle % cycles_per_scanline;
+	const cc_u32f hblank_start = CC_DIVIDE_CEILING(0xB3 * cycles_per_scanline, 0x100 - 0x30);
+
+	return MakeCycleMegaDrive(current_cycle.cycle - cycle_within_scanline + (cycle_within_scanline < hblank_start ? hblank_start : cycles_per_scanline));
+}
+
+static cc_bool IsCartridgeAddress(const ClownMDEmu* const clownmdemu, const cc_u32f address)
+{
+	return address < 0x800000
+		&& ((address & 0x400000) == 0) != clownmdemu->state->mega_cd.boot_from_cd
+		&& !((address & 0x200000) != 0 && clownmdemu->state->external_ram.mapped_in);
+}
+
+static cc_u16f ReadCartridge(const ClownMDEmu* const clownmdemu, const cc_u32f address, const cc_bool do_high_byte, const cc_bool do_low_byte)
+{
+	const ClownMDEmu_Callbacks* const frontend_callbacks = clownmdemu->callbacks;
+
+	cc_u16f value = 0;
+
+	if (do_high_byte)
+		value |= frontend_callbacks->cartridge_read((void*)frontend_callbacks->user_data, (address & 0x3FFFFF) + 0) << 8;
+	if (do_low_byte)
+		value |= frontend_callbacks->cartridge_read((void*)frontend_callbacks->user_data, (address & 0x3FFFFF) + 1) << 0;
+
+	return value;
+}
+
 static cc_u16f VDPReadCallback(void *user_data, cc_u32f address)
 {
 	return M68kReadCallbackWithDMA(user_data, address / 2, cc_true, cc_true, cc_true);
@@ -45,20 +76,84 @@ static void VDPKDebugCallback(void* const user_data, const char* const string)
 	LogMessage("KDEBUG: %s", string);
 }
 
+typedef struct SyncM68kCallbackUserData
+{
+	Clown68000_ReadWriteCallbacks read_write_callbacks;
+	CPUCallbackUserData *other_state;
+	cc_u32f target_cycle;
+	M68kIdleLoop idle_loop;
+} SyncM68kCallbackUserData;
+
 static cc_u16f SyncM68kCallback(const ClownMDEmu* const clownmdemu, void* const user_data)
 {
-	return CLOWNMDEMU_M68K_CLOCK_DIVIDER * Clown68000_DoCycle(clownmdemu->m68k, (const Clown68000_ReadWriteCallbacks*)user_data);
+	SyncM68kCallbackUserData* const sync_user_data = (SyncM68kCallbackUserData*)user_data;
+	M68kIdleLoop* const idle_loop = clownmdemu->configuration->general.m68k_idle_loop_skipping_disabled ? NULL : &sync_user_data->idle_loop;
+
+	return RunM68k(clownmdemu->m68k, &sync_user_data->read_write_callbacks, &sync_user_data->other_state->sync.m68k, CLOWNMDEMU_M68K_CLOCK_DIVIDER, sync_user_data->target_cycle, idle_loop);
+}
+
+static cc_u16f M68kIdleLoopReadCallback(const void* const user_data, const cc_u32f address_word, const cc_bool do_high_byte, const cc_bool do_low_byte)
+{
+	SyncM68kCallbackUserData* const sync_user_data = (SyncM68kCallbackUserData*)user_data;
+	CPUCallbackUserData* const other_state = sync_user_data->other_state;
+	const ClownMDEmu* const clownmdemu = other_state->clownmdemu;
+	const cc_u32f address = address_word * 2;
+
+	if (address >= 0xE00000
+		|| address == 0xA11100
+		|| IsCartridgeAddress(clownmdemu, address))
+	{
+		/* 68k RAM, the cartridge, and the Z80 BUSREQ flag cannot change without the 68k writing to something. */
+	}
+	else if (address == 0xC00004 || address == 0xC00006)
+	{
+		/* The only part of the VDP status which can change during a sync is the H-blank bit. */
+		const CycleMegaDrive next_change = GetNextHBlankBitChange(clownmdemu, MakeCycleMegaDrive(other_state->sync.m68k.current_cycle));
+
+		sync_user_data->idle_loop.end_cycle = CC_MIN(sync_user_data->idle_loop.end_cycle, next_change.cycle);
+	}
+	else
+	{
+		/* Anything else may have side-effects, or change on its own. */
+		sync_user_data->idle_loop.side_effects = cc_true;
+	}
+
+	return M68kReadCallback(other_state, address_word, do_high_byte, do_low_byte);
+}
+
+static void M68kIdleLoopWriteCallback(const void* const user_data, const cc_u32f address_word, const cc_bool do_high_byte, const cc_bool do_low_byte, const cc_u16f value)
+{
+	SyncM68kCallbackUserData* const sync_user_data = (SyncM68kCallbackUserData*)user_data;
+
+	sync_user_data->idle_loop.side_effects = cc_true;
+
+	M68kWriteCallback(sync_user_data->other_state, address_word, do_high_byte, do_low_byte, value);
 }
 
 void SyncM68k(const ClownMDEmu* const clownmdemu, CPUCallbackUserData* const other_state, const CycleMegaDrive target_cycle)
 {
-	Clown68000_ReadWriteCallbacks m68k_read_write_callbacks;
+	SyncM68kCallbackUserData sync_user_data;
+
+	sync_user_data.other_state = other_state;
+	sync_user_data.target_cycle = target_cycle.cycle;
+
+	if (clownmdemu->configuration->general.m68k_idle_loop_skipping_disabled)
+	{
+		sync_user_data.read_write_callbacks.read_callback = M68kReadCallback;
+		sync_user_data.read_write_callbacks.write_callback = M68kWriteCallback;
+		sync_user_data.read_write_callbacks.user_data = other_state;
+	}
+	else
+	{
+		/* Loops are only tracked within a single sync, since interrupts are raised between them. */
+		ResetM68kIdleLoop(&sync_user_data.idle_loop);
 
-	m68k_read_write_callbacks.read_callback = M68kReadCallback;
-	m68k_read_write_callbacks.write_callback = M68kWriteCallback;
-	m68k_read_write_callbacks.user_data = other_state;
+		sync_user_data.read_write_callbacks.read_callback = M68kIdleLoopReadCallback;
+		sync_user_data.read_write_callbacks.write_callback = M68kIdleLoopWriteCallback;
+		sync_user_data.read_write_callbacks.user_data = &sync_user_data;
+	}
 
-	SyncCPUCommon(clownmdemu, &other_state->sync.m68k, target_cycle.cycle, cc_false, SyncM68kCallback, &m68k_read_write_callbacks);
+	SyncCPUCommon(clownmdemu, &other_state->sync.m68k, target_cycle.cycle, cc_false, SyncM68kCallback, &sync_user_data);
 }
 
 cc_u16f M68kReadCallbackWithCycleWithDMA(const void* const user_data, const cc_u32f address_word, const cc_bool do_high_byte, const cc_bool do_low_byte, const CycleMegaDrive target_cycle, const cc_bool is_vdp_dma)
@@ -93,10 +188,7 @@ cc_u16f M68kReadCallbackWithCycleWithDMA(const void* const user_data, const cc_u
 			else
 			{
 				/* Cartridge */
-				if (do_high_byte)
-					value |= frontend_callbacks->cartridge_read((void*)frontend_callbacks->user_data, (address & 0x3FFFFF) + 0) << 8;
-				if (do_low_byte)
-					value |= frontend_callbacks->cartridge_read((void*)frontend_callbacks->user_data, (address & 0x3FFFFF) + 1) << 0;
+				value = ReadCartridge(clownmdemu, address, do_high_byte, do_low_byte);
 			}
 		}
 		else
@@ -404,6 +496,23 @@ cc_u16f M68kReadCallbackWithDMA(const void* const user_data, const cc_u32f addre
 
 cc_u16f M68kReadCallback(const void* const user_data, const cc_u32f address, const cc_bool do_high_byte, const cc_bool do_low_byte)
 {
+	/* 68k RAM is by far the most commonly-accessed region, but is at the very end of the address decoder, so give it a shortcut. */
+	if (address >= 0xE00000 / 2 && address <= 0xFFFFFF / 2)
+	{
+		const CPUCallbackUserData* const callback_user_data = (const CPUCallbackUserData*)user_data;
+
+		return callback_user_data->clownmdemu->state->m68k.ram[address & 0x7FFF];
+	}
+	else
+	{
+		/* Most instructions are fetched from the cartridge, which is near the start of the address decoder, but still behind a few layers of wrappers. */
+		const CPUCallbackUserData* const callback_user_data = (const CPUCallbackUserData*)user_data;
+		const ClownMDEmu* const clownmdemu = callback_user_data->clownmdemu;
+
+		if (IsCartridgeAddress(clownmdemu, address * 2))
+			return ReadCartridge(clownmdemu, address * 2, do_high_byte, do_low_byte);
+	}
+
 	return M68kReadCallbackWithDMA(user_data, address, do_high_byte, do_low_byte, cc_false);
 }
 
@@ -611,6 +720,8 @@ void M68kWriteCallbackWithCycle(const void* const user_data, const cc_u32f addre
 			{
 				SyncZ80(clownmdemu, callback_user_data, target_cycle);
 				Z80_Reset(&clownmdemu->z80);
+				/* Output the audio that is still pending before it is lost. */
+				FlushFM(callback_user_data);
 				FM_State_Initialise(&clownmdemu->state->fm);
 			}
 
@@ -752,6 +863,9 @@ void M68kWriteCallbackWithCycle(const void* const user_data, const cc_u32f addre
 
 			/* Alter the PSG's state */
 			PSG_DoCommand(&clownmdemu->psg, low_byte);
+
+			if (frontend_callbacks->sound_chip_written != NULL)
+				frontend_callbacks->sound_chip_written((void*)frontend_callbacks->user_data, CLOWNMDEMU_SOUND_CHIP_PSG, 0, 0, low_byte, callback_user_data->sync.psg.current_cycle * CLOWNMDEMU_Z80_CLOCK_DIVIDER * CLOWNMDEMU_PSG_SAMPLE_RATE_DIVIDER);
 		}
 	}
 	else if (address >= 0xE00000 && address <= 0xFFFFFF)
@@ -770,5 +884,17 @@ void M68kWriteCallback(const void* const user_data, const cc_u32f address, const
 {
 	CPUCallbackUserData* const callback_user_data = (CPUCallbackUserData*)user_data;
 
+	/* See 'M68kReadCallback'. */
+	if (address >= 0xE00000 / 2 && address <= 0xFFFFFF / 2)
+	{
+		cc_u16l* const word = &callback_user_data->clownmdemu->state->m68k.ram[address & 0x7FFF];
+		const cc_u16f mask = (do_high_byte ? 0xFF00 : 0) | (do_low_byte ? 0x00FF : 0);
+
+		*word &= ~mask;
+		*word |= value & mask;
+
+		return;
+	}
+
 	M68kWriteCallbackWithCycle(user_data, address, do_high_byte, do_low_byte, value, MakeCycleMegaDrive(callback_user_data->sync.m68k.current_cycle));
 }
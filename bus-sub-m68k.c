@@ -35,11 +35,33 @@ static cc_u16f MCDM68kReadWord(const void* const user_data, const cc_u32f addres
 	return MCDM68kReadCallbackWithCycle(user_data, (address & 0xFFFFFF) / 2, cc_true, cc_true, target_cycle);
 }
 
-static cc_u16f MCDM68kReadLongword(const void* const user_data, const cc_u32f address, const CycleMegaCD target_cycle)
+static cc_bool LongwordIsInPRGRAM(const cc_u32f address)
 {
+	/* PRG-RAM has no side-effects, so a longword which lies entirely within it only needs decoding once. */
+	return (address & 0xFFFFFF) + 3 < 0x80000;
+}
+
+static cc_u32f MCDM68kReadLongword(const void* const user_data, const cc_u32f address, const CycleMegaCD target_cycle)
+{
+	const CPUCallbackUserData* const callback_user_data = (const CPUCallbackUserData*)user_data;
+
 	cc_u32f longword;
-	longword = (cc_u32f)MCDM68kReadWord(user_data, address + 0, target_cycle) << 16;
-	longword |= (cc_u32f)MCDM68kReadWord(user_data, address + 2, target_cycle) << 0;
+
+	assert(address % 2 == 0);
+
+	if (LongwordIsInPRGRAM(address))
+	{
+		const cc_u16l* const words = &callback_user_data->clownmdemu->state->mega_cd.prg_ram.buffer[(address & 0xFFFFFF) / 2];
+
+		longword = (cc_u32f)words[0] << 16;
+		longword |= (cc_u32f)words[1] << 0;
+	}
+	else
+	{
+		longword = (cc_u32f)MCDM68kReadWord(user_data, address + 0, target_cycle) << 16;
+		longword |= (cc_u32f)MCDM68kReadWord(user_data, address + 2, target_cycle) << 0;
+	}
+
 	return longword;
 }
 
@@ -52,9 +74,23 @@ static void MCDM68kWriteWord(const void* const user_data, const cc_u32f address,
 
 static void MCDM68kWriteLongword(const void* const user_data, const cc_u32f address, const cc_u32f value, const CycleMegaCD target_cycle)
 {
+	const CPUCallbackUserData* const callback_user_data = (const CPUCallbackUserData*)user_data;
+
+	assert(address % 2 == 0);
 	assert(value <= 0xFFFFFFFF);
-	MCDM68kWriteWord(user_data, address + 0, value >> 16, target_cycle);
-	MCDM68kWriteWord(user_data, address + 2, value & 0xFFFF, target_cycle);
+
+	if (LongwordIsInPRGRAM(address))
+	{
+		cc_u16l* const words = &callback_user_data->clownmdemu->state->mega_cd.prg_ram.buffer[(address & 0xFFFFFF) / 2];
+
+		words[0] = value >> 16;
+		words[1] = value & 0xFFFF;
+	}
+	else
+	{
+		MCDM68kWriteWord(user_data, address + 0, value >> 16, target_cycle);
+		MCDM68kWriteWord(user_data, address + 2, value & 0xFFFF, target_cycle);
+	}
 }
 
 static void ROMSEEK(const ClownMDEmu* const clownmdemu, const void* const user_data, const ClownMDEmu_Callbacks* const frontend_callbacks, const CycleMegaCD target_cycle)
@@ -182,12 +218,12 @@ static void MegaCDBIOSCall(const ClownMDEmu* const clownmdemu, const void* const
 				clownmdemu->state->mega_cd.cd.cdc_ready = cc_false;
 				++clownmdemu->state->mega_cd.cd.current_sector;
 
-				for (i = 0; i < 0x800; i += 2)
+				for (i = 0; i < 0x800; i += 4)
 				{
 					const cc_u32f address = clownmdemu->mcd_m68k->address_registers[0] + i;
-					const cc_u16f sector_word = ((cc_u16f)sector_bytes[i + 0] << 8) | ((cc_u16f)sector_bytes[i + 1] << 0);
+					const cc_u32f sector_longword = ((cc_u32f)sector_bytes[i + 0] << 24) | ((cc_u32f)sector_bytes[i + 1] << 16) | ((cc_u32f)sector_bytes[i + 2] << 8) | ((cc_u32f)sector_bytes[i + 3] << 0);
 
-					MCDM68kWriteWord(user_data, address, sector_word, target_cycle);
+					MCDM68kWriteLongword(user_data, address, sector_longword, target_cycle);
 				}
 
 				MCDM68kWriteLongword(user_data, clownmdemu->mcd_m68k->address_registers[1], sector_header, target_cycle);
@@ -210,31 +246,75 @@ static void MegaCDBIOSCall(const ClownMDEmu* const clownmdemu, const void* const
 	}
 }
 
+typedef struct SyncMCDM68kCallbackUserData
+{
+	Clown68000_ReadWriteCallbacks read_write_callbacks;
+	CPUCallbackUserData *other_state;
+	cc_u32f target_cycle;
+	M68kIdleLoop idle_loop;
+} SyncMCDM68kCallbackUserData;
+
 static cc_u16f SyncMCDM68kForRealCallback(const ClownMDEmu* const clownmdemu, void* const user_data)
 {
-	const Clown68000_ReadWriteCallbacks* const m68k_read_write_callbacks = (const Clown68000_ReadWriteCallbacks*)user_data;
+	SyncMCDM68kCallbackUserData* const sync_user_data = (SyncMCDM68kCallbackUserData*)user_data;
+	M68kIdleLoop* const idle_loop = clownmdemu->configuration->general.mcd_m68k_idle_loop_skipping_disabled ? NULL : &sync_user_data->idle_loop;
+
+	return RunM68k(clownmdemu->mcd_m68k, &sync_user_data->read_write_callbacks, &sync_user_data->other_state->sync.mcd_m68k, CLOWNMDEMU_MCD_M68K_CLOCK_DIVIDER, sync_user_data->target_cycle, idle_loop);
+}
+
+static cc_u16f MCDM68kIdleLoopReadCallback(const void* const user_data, const cc_u32f address_word, const cc_bool do_high_byte, const cc_bool do_low_byte)
+{
+	SyncMCDM68kCallbackUserData* const sync_user_data = (SyncMCDM68kCallbackUserData*)user_data;
+	const cc_u32f address = address_word * 2;
+
+	if ((address < 0x80000 && address != 0x5F16 && address != 0x5F22)
+		|| address == 0xFF8002
+		|| (address >= 0xFF800E && address < 0xFF8030))
+	{
+		/* PRG-RAM, the memory mode register, and the communication registers can only be changed by the SUB-CPU
+		   itself, or by the MAIN-CPU, which always synchronises the SUB-CPU before doing so. This covers the loops
+		   where the SUB-CPU waits on the MAIN-CPU. The BIOS call addresses are excluded as they are handled by
+		   the bus itself. */
+	}
+	else
+	{
+		/* Anything else may have side-effects, or change on its own. */
+		sync_user_data->idle_loop.side_effects = cc_true;
+	}
+
+	return MCDM68kReadCallback(sync_user_data->other_state, address_word, do_high_byte, do_low_byte);
+}
+
+static void MCDM68kIdleLoopWriteCallback(const void* const user_data, const cc_u32f address_word, const cc_bool do_high_byte, const cc_bool do_low_byte, const cc_u16f value)
+{
+	SyncMCDM68kCallbackUserData* const sync_user_data = (SyncMCDM68kCallbackUserData*)user_data;
+
+	sync_user_data->idle_loop.side_effects = cc_true;
 
-	return CLOWNMDEMU_MCD_M68K_CLOCK_DIVIDER * Clown68000_DoCycle(clownmdemu->mcd_m68k, m68k_read_write_callbacks);
+	MCDM68kWriteCallback(sync_user_data->other_state, address_word, do_high_byte, do_low_byte, value);
 }
 
-void SyncMCDM68kForReal(const ClownMDEmu* const clownmdemu, const Clown68000_ReadWriteCallbacks* const m68k_read_write_callbacks, const CycleMegaCD target_cycle)
+static void SyncMCDM68kForReal(const ClownMDEmu* const clownmdemu, SyncMCDM68kCallbackUserData* const sync_user_data, const CycleMegaCD target_cycle)
 {
 	const cc_bool mcd_m68k_not_running = clownmdemu->state->mega_cd.m68k.bus_requested || clownmdemu->state->mega_cd.m68k.reset_held;
 
-	CPUCallbackUserData* const other_state = (CPUCallbackUserData*)m68k_read_write_callbacks->user_data;
+	sync_user_data->target_cycle = target_cycle.cycle;
+
+	/* Loops are only tracked within a single sync, since interrupts are raised between them. */
+	ResetM68kIdleLoop(&sync_user_data->idle_loop);
 
-	SyncCPUCommon(clownmdemu, &other_state->sync.mcd_m68k, target_cycle.cycle, mcd_m68k_not_running, SyncMCDM68kForRealCallback, m68k_read_write_callbacks);
+	SyncCPUCommon(clownmdemu, &sync_user_data->other_state->sync.mcd_m68k, target_cycle.cycle, mcd_m68k_not_running, SyncMCDM68kForRealCallback, sync_user_data);
 }
 
 static cc_u16f SyncMCDM68kCallback(const ClownMDEmu* const clownmdemu, void* const user_data)
 {
-	const Clown68000_ReadWriteCallbacks* const m68k_read_write_callbacks = (const Clown68000_ReadWriteCallbacks*)user_data;
-	CPUCallbackUserData* const other_state = (CPUCallbackUserData*)m68k_read_write_callbacks->user_data;
+	SyncMCDM68kCallbackUserData* const sync_user_data = (SyncMCDM68kCallbackUserData*)user_data;
+	CPUCallbackUserData* const other_state = sync_user_data->other_state;
 	CycleMegaCD current_cycle;
 
 	/* Update the 68000 to this point in time. */
 	current_cycle.cycle = other_state->sync.mcd_m68k_irq3.current_cycle;
-	SyncMCDM68kForReal(clownmdemu, m68k_read_write_callbacks, current_cycle);
+	SyncMCDM68kForReal(clownmdemu, sync_user_data, current_cycle);
 
 	/* Raise an interrupt. */
 	if (clownmdemu->state->mega_cd.irq.enabled[2])
@@ -245,18 +325,29 @@ static cc_u16f SyncMCDM68kCallback(const ClownMDEmu* const clownmdemu, void* con
 
 void SyncMCDM68k(const ClownMDEmu* const clownmdemu, CPUCallbackUserData* const other_state, const CycleMegaCD target_cycle)
 {
-	Clown68000_ReadWriteCallbacks m68k_read_write_callbacks;
+	SyncMCDM68kCallbackUserData sync_user_data;
 
-	m68k_read_write_callbacks.read_callback = MCDM68kReadCallback;
-	m68k_read_write_callbacks.write_callback = MCDM68kWriteCallback;
-	m68k_read_write_callbacks.user_data = other_state;
+	sync_user_data.other_state = other_state;
+
+	if (clownmdemu->configuration->general.mcd_m68k_idle_loop_skipping_disabled)
+	{
+		sync_user_data.read_write_callbacks.read_callback = MCDM68kReadCallback;
+		sync_user_data.read_write_callbacks.write_callback = MCDM68kWriteCallback;
+		sync_user_data.read_write_callbacks.user_data = other_state;
+	}
+	else
+	{
+		sync_user_data.read_write_callbacks.read_callback = MCDM68kIdleLoopReadCallback;
+		sync_user_data.read_write_callbacks.write_callback = MCDM68kIdleLoopWriteCallback;
+		sync_user_data.read_write_callbacks.user_data = &sync_user_data;
+	}
 
 	/* In order to support the timer interrupt (IRQ3), we hijack this function to update an IRQ3 sync object instead. */
 	/* This sync object will raise interrupts whilst also synchronising the 68000. */
-	SyncCPUCommon(clownmdemu, &other_state->sync.mcd_m68k_irq3, target_cycle.cycle, cc_false, SyncMCDM68kCallback, &m68k_read_write_callbacks);
+	SyncCPUCommon(clownmdemu, &other_state->sync.mcd_m68k_irq3, target_cycle.cycle, cc_false, SyncMCDM68kCallback, &sync_user_data);
 
 	/* Now that we're done with IRQ3, finish synchronising the 68000. */
-	SyncMCDM68kForReal(clownmdemu, &m68k_read_write_callbacks, target_cycle);
+	SyncMCDM68kForReal(clownmdemu, &sync_user_data, target_cycle);
 }
 
 cc_u16f MCDM68kReadCallbackWithCycle(const void* const user_data, const cc_u32f address_word, const cc_bool do_high_byte, const cc_bool do_low_byte, const CycleMegaCD target_cycle)
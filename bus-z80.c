@@ -7,22 +7,239 @@
 
 /* TODO: https://sonicresearch.org/community/index.php?threads/help-with-potentially-extra-ram-space-for-z80-sound-drivers.6763/#post-89797 */
 
+/* The most Z80 cycles to run in one go: the countdown is 16-bit, so leave room for the last instruction to overrun this. */
+#define Z80_CYCLE_BUDGET_MAXIMUM 0x1000
+
+typedef struct Z80IdleLoop
+{
+	Z80_State snapshot; /* The CPU's state at the start of the current iteration. */
+	cc_u32f start_cycle;
+	cc_bool tracking;
+	cc_bool side_effects;
+	cc_bool fm_polled;
+	cc_u8l fm_status;
+	cc_u16l code_start;
+	cc_u16l code_end;
+} Z80IdleLoop;
+
+typedef struct SyncZ80CallbackUserData
+{
+	Z80_ReadAndWriteCallbacks read_write_callbacks;
+	CPUCallbackUserData *other_state;
+	cc_u32f target_cycle;
+	Z80IdleLoop idle_loop;
+} SyncZ80CallbackUserData;
+
+static void UpdateZ80BankWindow(CPUCallbackUserData* const callback_user_data)
+{
+	const ClownMDEmu* const clownmdemu = callback_user_data->clownmdemu;
+	const cc_u32f m68k_address = (cc_u32f)clownmdemu->state->z80.bank * 0x8000;
+
+	/* The window is 0x8000 bytes, which is small enough to never straddle two regions of the 68k's address space. */
+	if (m68k_address >= 0xE00000)
+		callback_user_data->z80_bank_window = Z80_BANK_WINDOW_68K_RAM;
+	else if (m68k_address < 0x800000 && ((m68k_address & 0x400000) == 0) != clownmdemu->state->mega_cd.boot_from_cd && !((m68k_address & 0x200000) != 0 && clownmdemu->state->external_ram.mapped_in))
+		callback_user_data->z80_bank_window = Z80_BANK_WINDOW_CARTRIDGE;
+	else
+		callback_user_data->z80_bank_window = Z80_BANK_WINDOW_OTHER;
+}
+
+static cc_u32f BeginZ80Access(CPUCallbackUserData* const callback_user_data)
+{
+	/* 'Z80_Run' does several instructions per step of the sync, so temporarily bring the sync up to the current
+	   instruction. This way, the access happens at the right time, and anything that synchronises the Z80 (such as
+	   writing to the PSG) sees that it is already up to date. */
+	const cc_u32f run_start_cycle = callback_user_data->sync.z80.current_cycle;
+
+	callback_user_data->sync.z80.current_cycle += CLOWNMDEMU_Z80_CLOCK_DIVIDER * callback_user_data->clownmdemu->state->z80.state.run_cycles;
+
+	return run_start_cycle;
+}
+
+static cc_u32f GetZ80CycleBudget(const SyncZ80CallbackUserData* const sync_user_data)
+{
+	/* Every instruction that begins at or before the target cycle must be executed. */
+	return CC_MIN((sync_user_data->target_cycle - sync_user_data->other_state->sync.z80.current_cycle) / CLOWNMDEMU_Z80_CLOCK_DIVIDER + 1, Z80_CYCLE_BUDGET_MAXIMUM);
+}
+
 static cc_u16f SyncZ80Callback(const ClownMDEmu* const clownmdemu, void* const user_data)
 {
-	return CLOWNMDEMU_Z80_CLOCK_DIVIDER * Z80_DoCycle(&clownmdemu->z80, (const Z80_ReadAndWriteCallbacks*)user_data);
+	const SyncZ80CallbackUserData* const sync_user_data = (const SyncZ80CallbackUserData*)user_data;
+
+	return CLOWNMDEMU_Z80_CLOCK_DIVIDER * Z80_Run(&clownmdemu->z80, &sync_user_data->read_write_callbacks, GetZ80CycleBudget(sync_user_data));
+}
+
+static void BeginIdleLoopIteration(Z80IdleLoop* const idle_loop, const Z80_State* const z80_state, const cc_u32f cycle)
+{
+	idle_loop->snapshot = *z80_state;
+	idle_loop->start_cycle = cycle;
+	idle_loop->tracking = cc_true;
+	idle_loop->side_effects = cc_false;
+	idle_loop->fm_polled = cc_false;
+	idle_loop->code_start = z80_state->program_counter;
+	idle_loop->code_end = z80_state->program_counter;
+}
+
+static cc_bool IdleLoopAccessesRRegister(const ClownMDEmu* const clownmdemu, const Z80IdleLoop* const idle_loop)
+{
+	/* Instruction fetches from Z80 RAM bypass the bus, so scan the loop's code for 'LD A,R' and 'LD R,A' instead.
+	   These make the 'R' register an input to the loop. Every instruction that was executed lies within this range. */
+	cc_u16f i;
+
+	for (i = idle_loop->code_start; i + 1 < idle_loop->code_end; ++i)
+		if (clownmdemu->state->z80.ram[i] == 0xED && (clownmdemu->state->z80.ram[i + 1] == 0x4F || clownmdemu->state->z80.ram[i + 1] == 0x5F))
+			return cc_true;
+
+	return cc_false;
+}
+
+static cc_u16f SyncZ80IdleLoopCallback(const ClownMDEmu* const clownmdemu, void* const user_data)
+{
+	SyncZ80CallbackUserData* const sync_user_data = (SyncZ80CallbackUserData*)user_data;
+	Z80IdleLoop* const idle_loop = &sync_user_data->idle_loop;
+	Z80_State* const z80_state = clownmdemu->z80.state;
+	const cc_u16f block_start = z80_state->program_counter;
+	const cc_u32f current_cycle = sync_user_data->other_state->sync.z80.current_cycle;
+	const cc_u32f block_cycles = Z80_Run(&clownmdemu->z80, &sync_user_data->read_write_callbacks, GetZ80CycleBudget(sync_user_data));
+
+	cc_u32f cycles;
+
+	cycles = CLOWNMDEMU_Z80_CLOCK_DIVIDER * block_cycles;
+
+	/* The block was straight-line code, and no instruction is longer than the number of cycles that it takes,
+	   so this range covers every byte that was executed. */
+	idle_loop->code_start = CC_MIN(idle_loop->code_start, block_start);
+	idle_loop->code_end = CC_MAX(idle_loop->code_end, CC_MIN(block_start + block_cycles, 0xFFFF));
+
+	if (idle_loop->tracking && z80_state->program_counter == idle_loop->snapshot.program_counter)
+	{
+		/* An iteration of the loop has completed. If it left the CPU exactly as it found it, and its only inputs were
+		   Z80 RAM and the FM status, then every iteration until the next external event will behave identically,
+		   so they can be skipped. Nothing outside of the Z80 can change until this sync is over, so the only events
+		   to watch out for are the end of the sync and the FM status changing. */
+		if (!idle_loop->side_effects
+			&& !(z80_state->interrupt_pending && z80_state->interrupts_enabled)
+			&& Z80_StatesMatch(z80_state, &idle_loop->snapshot)
+			/* Only bother with short loops that run from RAM. */
+			&& idle_loop->code_end - idle_loop->code_start <= 0x100
+			&& idle_loop->code_end <= CC_COUNT_OF(clownmdemu->state->z80.ram)
+			&& !IdleLoopAccessesRRegister(clownmdemu, idle_loop))
+		{
+			const cc_u32f next_cycle = current_cycle + cycles;
+			const cc_u32f iteration_cycles = next_cycle - idle_loop->start_cycle;
+
+			cc_u32f end_cycle;
+
+			end_cycle = sync_user_data->target_cycle;
+
+			if (idle_loop->fm_polled)
+			{
+				const cc_u32f fm_cycles = FM_GetCyclesUntilNextEvent(&clownmdemu->fm);
+
+				if (fm_cycles < end_cycle / CLOWNMDEMU_M68K_CLOCK_DIVIDER)
+					end_cycle = CC_MIN(end_cycle, (sync_user_data->other_state->sync.fm.current_cycle + fm_cycles) * CLOWNMDEMU_M68K_CLOCK_DIVIDER);
+			}
+
+			if (end_cycle > next_cycle)
+			{
+				/* The countdown is 16-bit, so do not skip too far at once. */
+				const cc_u32f iterations = CC_MIN((end_cycle - next_cycle) / iteration_cycles, (0xFFFF - cycles) / iteration_cycles);
+				const cc_u32f r_delta = (z80_state->r + 0x80 - idle_loop->snapshot.r) & 0x7F;
+
+				cycles += iterations * iteration_cycles;
+
+				/* Only the lower 7 bits of the 'R' register are incremented by opcode fetches. */
+				z80_state->r = (z80_state->r & 0x80) | (((cc_u32f)z80_state->r + iterations * r_delta) & 0x7F);
+			}
+		}
+
+		BeginIdleLoopIteration(idle_loop, z80_state, current_cycle + cycles);
+	}
+	else if (z80_state->program_counter <= block_start)
+	{
+		/* A backwards branch: this could be the start of a loop. */
+		BeginIdleLoopIteration(idle_loop, z80_state, current_cycle + cycles);
+	}
+
+	return cycles;
+}
+
+static cc_u16f Z80IdleLoopReadCallback(const void* const user_data, const cc_u16f address)
+{
+	SyncZ80CallbackUserData* const sync_user_data = (SyncZ80CallbackUserData*)user_data;
+	Z80IdleLoop* const idle_loop = &sync_user_data->idle_loop;
+	const cc_u16f value = Z80ReadCallback(sync_user_data->other_state, address);
+
+	if (address < 0x2000)
+	{
+		/* Z80 RAM cannot change without the Z80 writing to it. */
+	}
+	else if (address >= 0x4000 && address <= 0x4003)
+	{
+		/* The FM status can only change at predictable times, but every read of it must agree for the iteration to be repeatable. */
+		if (!idle_loop->fm_polled)
+		{
+			idle_loop->fm_polled = cc_true;
+			idle_loop->fm_status = value;
+		}
+		else if (idle_loop->fm_status != value)
+		{
+			idle_loop->side_effects = cc_true;
+		}
+	}
+	else if (address != 0x6000 && address != 0x6001 && address != 0x7F11)
+	{
+		/* Reads from the 68k's bus cannot be assumed to be free of side-effects. */
+		idle_loop->side_effects = cc_true;
+	}
+
+	return value;
+}
+
+static void Z80IdleLoopWriteCallback(const void* const user_data, const cc_u16f address, const cc_u16f value)
+{
+	SyncZ80CallbackUserData* const sync_user_data = (SyncZ80CallbackUserData*)user_data;
+
+	sync_user_data->idle_loop.side_effects = cc_true;
+
+	Z80WriteCallback(sync_user_data->other_state, address, value);
 }
 
 void SyncZ80(const ClownMDEmu* const clownmdemu, CPUCallbackUserData* const other_state, const CycleMegaDrive target_cycle)
 {
 	const cc_bool z80_not_running = clownmdemu->state->z80.bus_requested || clownmdemu->state->z80.reset_held;
 
-	Z80_ReadAndWriteCallbacks z80_read_write_callbacks;
+	SyncZ80CallbackUserData sync_user_data;
+
+	sync_user_data.other_state = other_state;
+	sync_user_data.target_cycle = target_cycle.cycle;
 
-	z80_read_write_callbacks.read = Z80ReadCallback;
-	z80_read_write_callbacks.write = Z80WriteCallback;
-	z80_read_write_callbacks.user_data = other_state;
+	/* Z80 RAM has no side-effects, so the Z80 can access it directly. */
+	sync_user_data.read_write_callbacks.memory = clownmdemu->state->z80.ram;
+	sync_user_data.read_write_callbacks.memory_size = CC_COUNT_OF(clownmdemu->state->z80.ram);
 
-	SyncCPUCommon(clownmdemu, &other_state->sync.z80, target_cycle.cycle, z80_not_running, SyncZ80Callback, &z80_read_write_callbacks);
+	/* The 68k may have changed the memory map since the last sync. */
+	UpdateZ80BankWindow(other_state);
+
+	if (clownmdemu->configuration->general.z80_idle_loop_skipping_disabled)
+	{
+		sync_user_data.read_write_callbacks.read = Z80ReadCallback;
+		sync_user_data.read_write_callbacks.write = Z80WriteCallback;
+		sync_user_data.read_write_callbacks.user_data = other_state;
+
+		SyncCPUCommon(clownmdemu, &other_state->sync.z80, target_cycle.cycle, z80_not_running, SyncZ80Callback, &sync_user_data);
+	}
+	else
+	{
+		/* Loops are only tracked within a single sync, since the 68k may modify Z80 RAM between them. */
+		sync_user_data.idle_loop.tracking = cc_false;
+
+		sync_user_data.read_write_callbacks.read = Z80IdleLoopReadCallback;
+		sync_user_data.read_write_callbacks.write = Z80IdleLoopWriteCallback;
+		sync_user_data.read_write_callbacks.user_data = &sync_user_data;
+
+		SyncCPUCommon(clownmdemu, &other_state->sync.z80, target_cycle.cycle, z80_not_running, SyncZ80IdleLoopCallback, &sync_user_data);
+	}
 }
 
 cc_u16f Z80ReadCallbackWithCycle(const void* const user_data, const cc_u16f address, const CycleMegaDrive target_cycle)
@@ -60,12 +277,35 @@ cc_u16f Z80ReadCallbackWithCycle(const void* const user_data, const cc_u16f addr
 		/* 68k ROM window (actually a window into the 68k's address space: you can access the PSG through it IIRC). */
 		const cc_u32f m68k_address = ((cc_u32f)clownmdemu->state->z80.bank * 0x8000) + (address & 0x7FFE);
 
-		SyncM68k(clownmdemu, callback_user_data, target_cycle);
+		switch (callback_user_data->z80_bank_window)
+		{
+			case Z80_BANK_WINDOW_CARTRIDGE:
+				/* Drivers stream DAC samples from here a byte at a time, so bypass the 68k's address decoding.
+				   Nothing that the 68k does can affect what is read, so the sync is unnecessary too. */
+				value = clownmdemu->callbacks->cartridge_read((void*)clownmdemu->callbacks->user_data, (m68k_address & 0x3FFFFF) + (address & 1));
+				break;
 
-		if ((address & 1) != 0)
-			value = M68kReadCallbackWithCycle(user_data, m68k_address / 2, cc_false, cc_true, target_cycle);
-		else
-			value = M68kReadCallbackWithCycle(user_data, m68k_address / 2, cc_true, cc_false, target_cycle) >> 8;
+			case Z80_BANK_WINDOW_68K_RAM:
+				SyncM68k(clownmdemu, callback_user_data, target_cycle);
+				value = clownmdemu->state->m68k.ram[(m68k_address / 2) & 0x7FFF];
+
+				if ((address & 1) != 0)
+					value &= 0xFF;
+				else
+					value >>= 8;
+
+				break;
+
+			case Z80_BANK_WINDOW_OTHER:
+				SyncM68k(clownmdemu, callback_user_data, target_cycle);
+
+				if ((address & 1) != 0)
+					value = M68kReadCallbackWithCycle(user_data, m68k_address / 2, cc_false, cc_true, target_cycle);
+				else
+					value = M68kReadCallbackWithCycle(user_data, m68k_address / 2, cc_true, cc_false, target_cycle) >> 8;
+
+				break;
+		}
 	}
 	else
 	{
@@ -78,8 +318,12 @@ cc_u16f Z80ReadCallbackWithCycle(const void* const user_data, const cc_u16f addr
 cc_u16f Z80ReadCallback(const void* const user_data, const cc_u16f address)
 {
 	CPUCallbackUserData* const callback_user_data = (CPUCallbackUserData*)user_data;
+	const cc_u32f run_start_cycle = BeginZ80Access(callback_user_data);
+	const cc_u16f value = Z80ReadCallbackWithCycle(user_data, address, MakeCycleMegaDrive(callback_user_data->sync.z80.current_cycle));
 
-	return Z80ReadCallbackWithCycle(user_data, address, MakeCycleMegaDrive(callback_user_data->sync.z80.current_cycle));
+	callback_user_data->sync.z80.current_cycle = run_start_cycle;
+
+	return value;
 }
 
 void Z80WriteCallbackWithCycle(const void* const user_data, const cc_u16f address, const cc_u16f value, const CycleMegaDrive target_cycle)
@@ -100,14 +344,23 @@ void Z80WriteCallbackWithCycle(const void* const user_data, const cc_u16f addres
 		SyncFM(callback_user_data, target_cycle);
 
 		if ((address & 1) == 0)
+		{
 			FM_DoAddress(&clownmdemu->fm, port, value);
+		}
 		else
+		{
 			FM_DoData(&clownmdemu->fm, value);
+
+			if (clownmdemu->callbacks->sound_chip_written != NULL)
+				clownmdemu->callbacks->sound_chip_written((void*)clownmdemu->callbacks->user_data, CLOWNMDEMU_SOUND_CHIP_FM, clownmdemu->state->fm.port / 3, clownmdemu->state->fm.address, value, callback_user_data->sync.fm.current_cycle * CLOWNMDEMU_M68K_CLOCK_DIVIDER);
+		}
 	}
 	else if (address == 0x6000 || address == 0x6001)
 	{
 		clownmdemu->state->z80.bank >>= 1;
 		clownmdemu->state->z80.bank |= (value & 1) != 0 ? 0x100 : 0;
+
+		UpdateZ80BankWindow(callback_user_data);
 	}
 	else if (address == 0x7F11)
 	{
@@ -142,6 +395,9 @@ void Z80WriteCallbackWithCycle(const void* const user_data, const cc_u16f addres
 void Z80WriteCallback(const void* const user_data, const cc_u16f address, const cc_u16f value)
 {
 	CPUCallbackUserData* const callback_user_data = (CPUCallbackUserData*)user_data;
+	const cc_u32f run_start_cycle = BeginZ80Access(callback_user_data);
 
 	Z80WriteCallbackWithCycle(user_data, address, value, MakeCycleMegaDrive(callback_user_data->sync.z80.current_cycle));
+
+	callback_user_data->sync.z80.current_cycle = run_start_cycle;
 }
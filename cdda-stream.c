@@ -0,0 +1,147 @@
+#include "cdda-stream.h"
+
+#include <string.h>
+
+#include "clowncommon/clowncommon.h"
+
+/* The buffer's size must divide into the counters' range, so that they can wrap around freely. */
+#define COUNTER_MASK 0xFFFFFFFF
+
+static void ReleaseBarrier(const CDDAStream* const stream)
+{
+	stream->release_barrier((void*)stream->user_data);
+}
+
+static void AcquireBarrier(const CDDAStream* const stream)
+{
+	stream->acquire_barrier((void*)stream->user_data);
+}
+
+void CDDAStream_Parameters_Initialise(CDDAStream* const stream, CDDAStream_State* const state, const CDDAStream_SeekCallback seek_callback, const CDDAStream_ReadCallback read_callback, const CDDAStream_BarrierCallback release_barrier, const CDDAStream_BarrierCallback acquire_barrier, const void* const user_data)
+{
+	stream->state = state;
+	stream->seek_callback = seek_callback;
+	stream->read_callback = read_callback;
+	stream->release_barrier = release_barrier;
+	stream->acquire_barrier = acquire_barrier;
+	stream->user_data = user_data;
+}
+
+void CDDAStream_State_Initialise(CDDAStream_State* const state)
+{
+	state->write_index = 0;
+	state->read_index = 0;
+	state->seeks_requested = 0;
+	state->seeks_done = 0;
+	state->seeks_skipped = 0;
+	state->seek_write_index = 0;
+	state->seek_track_index = 0;
+	state->seek_mode = CLOWNMDEMU_CDDA_PLAY_ALL;
+}
+
+void CDDAStream_Seek(const CDDAStream* const stream, const cc_u16f track_index, const ClownMDEmu_CDDAMode mode)
+{
+	CDDAStream_State* const state = stream->state;
+
+	state->seek_track_index = track_index;
+	state->seek_mode = mode;
+
+	/* The request must be filled-in before it is made. */
+	ReleaseBarrier(stream);
+	state->seeks_requested = (state->seeks_requested + 1) & COUNTER_MASK;
+}
+
+size_t CDDAStream_Read(const CDDAStream* const stream, cc_s16l* const sample_buffer, const size_t total_frames)
+{
+	CDDAStream_State* const state = stream->state;
+	const cc_u32f seeks_done = state->seeks_done;
+
+	cc_u32f read_index, write_index, frames_to_do, read_position, frames_until_wrap;
+
+	/* Output silence until the reader thread has caught up with the seeks. */
+	if (state->seeks_requested != seeks_done)
+		return 0;
+
+	/* Make sure that 'seek_write_index' is read after 'seeks_done'. */
+	AcquireBarrier(stream);
+
+	read_index = state->read_index;
+
+	/* Skip the audio which was buffered before the seek. */
+	if (state->seeks_skipped != seeks_done)
+	{
+		read_index = state->seek_write_index;
+		state->seeks_skipped = seeks_done;
+	}
+
+	write_index = state->write_index;
+
+	/* Make sure that the audio is read after 'write_index', so that it has been written. */
+	AcquireBarrier(stream);
+
+	frames_to_do = CC_MIN(total_frames, (write_index - read_index) & COUNTER_MASK);
+	read_position = read_index % CDDA_STREAM_BUFFER_FRAMES;
+	frames_until_wrap = CC_MIN(frames_to_do, CDDA_STREAM_BUFFER_FRAMES - read_position);
+
+	memcpy(sample_buffer, &state->buffer[read_position * 2], frames_until_wrap * 2 * sizeof(*sample_buffer));
+	memcpy(&sample_buffer[frames_until_wrap * 2], state->buffer, (frames_to_do - frames_until_wrap) * 2 * sizeof(*sample_buffer));
+
+	/* Only hand the space back to the reader thread once the audio has been copied out of it. */
+	ReleaseBarrier(stream);
+	state->read_index = (read_index + frames_to_do) & COUNTER_MASK;
+
+	return frames_to_do;
+}
+
+size_t CDDAStream_Fill(const CDDAStream* const stream)
+{
+	CDDAStream_State* const state = stream->state;
+	const cc_u32f seeks_requested = state->seeks_requested;
+
+	cc_u32f write_index = state->write_index;
+	size_t total_frames_read = 0;
+
+	if (seeks_requested != state->seeks_done)
+	{
+		/* Make sure that the request is read after 'seeks_requested', so that it has been filled-in. */
+		AcquireBarrier(stream);
+
+		/* If another seek is requested while this one is being done, then it will be picked up by the next call. */
+		stream->seek_callback((void*)stream->user_data, state->seek_track_index, (ClownMDEmu_CDDAMode)state->seek_mode);
+
+		/* The emulation thread will discard everything before this point. */
+		state->seek_write_index = write_index;
+		ReleaseBarrier(stream);
+		state->seeks_done = seeks_requested;
+	}
+
+	for (;;)
+	{
+		const cc_u32f read_index = state->read_index;
+		const cc_u32f write_position = write_index % CDDA_STREAM_BUFFER_FRAMES;
+		const cc_u32f free_frames = CDDA_STREAM_BUFFER_FRAMES - ((write_index - read_index) & COUNTER_MASK);
+		const cc_u32f frames_to_do = CC_MIN(free_frames, CDDA_STREAM_BUFFER_FRAMES - write_position);
+
+		size_t frames_read;
+
+		if (frames_to_do == 0)
+			break;
+
+		/* Make sure that the space is written after 'read_index', so that the audio has been copied out of it. */
+		AcquireBarrier(stream);
+
+		frames_read = stream->read_callback((void*)stream->user_data, &state->buffer[write_position * 2], frames_to_do);
+
+		/* Only hand the audio to the emulation thread once it has been written. */
+		write_index = (write_index + frames_read) & COUNTER_MASK;
+		ReleaseBarrier(stream);
+		state->write_index = write_index;
+		total_frames_read += frames_read;
+
+		/* Stop if the track has ended. */
+		if (frames_read != frames_to_do)
+			break;
+	}
+
+	return total_frames_read;
+}
@@ -0,0 +1,85 @@
+#ifndef CDDA_STREAM_H
+#define CDDA_STREAM_H
+
+#include <stddef.h>
+
+#include "clowncommon/clowncommon.h"
+
+#include "clownmdemu.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* How many frames of CD audio can be read ahead of playback. This is about a third of a second. */
+#define CDDA_STREAM_BUFFER_FRAMES 0x4000
+
+typedef struct CDDAStream_State
+{
+	cc_s16l buffer[CDDA_STREAM_BUFFER_FRAMES * 2];
+	/* These count frames, and wrap around. */
+	volatile cc_u32l write_index; /* Written by the reader thread. */
+	volatile cc_u32l read_index; /* Written by the emulation thread. */
+	/* A seek is pending while 'seeks_requested' and 'seeks_done' differ. Once it is done, the emulation thread
+	   skips ahead to 'seek_write_index', where the new track's audio begins, and catches 'seeks_skipped' up. */
+	volatile cc_u32l seeks_requested; /* Written by the emulation thread. */
+	volatile cc_u32l seeks_done; /* Written by the reader thread. */
+	volatile cc_u32l seeks_skipped; /* Written by the emulation thread. */
+	volatile cc_u32l seek_write_index; /* Written by the reader thread. */
+	/* The track to seek to. Written by the emulation thread. */
+	volatile cc_u16l seek_track_index;
+	volatile cc_u8l seek_mode; /* ClownMDEmu_CDDAMode */
+} CDDAStream_State;
+
+typedef cc_bool (*CDDAStream_SeekCallback)(void *user_data, cc_u16f track_index, ClownMDEmu_CDDAMode mode);
+typedef size_t (*CDDAStream_ReadCallback)(void *user_data, cc_s16l *sample_buffer, size_t total_frames);
+typedef void (*CDDAStream_BarrierCallback)(void *user_data);
+
+typedef struct CDDAStream
+{
+	CDDAStream_State *state;
+	/* Used by the reader thread only. These behave like the emulator's 'cd_track_seeked' and 'cd_audio_read'
+	   callbacks, including the handling of the playback mode. */
+	CDDAStream_SeekCallback seek_callback;
+	CDDAStream_ReadCallback read_callback;
+	/* Used by both threads. C89 has no way to order memory accesses between threads, so these must be memory barriers,
+	   such as C11's 'atomic_thread_fence(memory_order_release)' and 'atomic_thread_fence(memory_order_acquire)'.
+	   'release_barrier' must stop earlier writes from being seen after later writes, and 'acquire_barrier' must stop
+	   later reads and writes from happening before earlier reads. They must also stop the compiler from moving
+	   accesses across them. A full barrier will do for both. */
+	CDDAStream_BarrierCallback release_barrier;
+	CDDAStream_BarrierCallback acquire_barrier;
+	const void *user_data;
+} CDDAStream;
+
+/* An optional component for frontends, which moves CD audio reading off of the emulation thread.
+   A reader thread calls 'CDDAStream_Fill' to read ahead into a ring buffer, while the emulator's 'cd_track_seeked'
+   and 'cd_audio_read' callbacks are forwarded to 'CDDAStream_Seek' and 'CDDAStream_Read', which do not read the disc.
+   Each counter in the state is only ever written by one of the two threads, and is published and consumed through the
+   barrier callbacks, so no locking is needed.
+
+   This only covers CD audio: the emulator's 'cd_seeked' and 'cd_sector_read' callbacks still read the data track
+   on the emulation thread, concurrently with the reader thread. So, the seek and read callbacks must use a handle
+   to the disc which is separate from the one used by those, or else the frontend must serialise access to the disc
+   itself. */
+void CDDAStream_Parameters_Initialise(CDDAStream *stream, CDDAStream_State *state, CDDAStream_SeekCallback seek_callback, CDDAStream_ReadCallback read_callback, CDDAStream_BarrierCallback release_barrier, CDDAStream_BarrierCallback acquire_barrier, const void *user_data);
+/* Must be called before either thread uses the stream. */
+void CDDAStream_State_Initialise(CDDAStream_State *state);
+
+/* For the emulation thread. */
+/* Discards the buffered audio, and has the reader thread seek to the given track. */
+void CDDAStream_Seek(const CDDAStream *stream, cc_u16f track_index, ClownMDEmu_CDDAMode mode);
+/* Outputs as many buffered frames as possible, up to 'total_frames', and returns how many were output.
+   Nothing is output until the reader thread has handled any pending seek. */
+size_t CDDAStream_Read(const CDDAStream *stream, cc_s16l *sample_buffer, size_t total_frames);
+
+/* For the reader thread. */
+/* Handles any pending seek, and then reads audio until the buffer is full or 'read_callback' runs out.
+   Returns how many frames were read. */
+size_t CDDAStream_Fill(const CDDAStream *stream);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CDDA_STREAM_H */
@@ -356,9 +356,10 @@ void ClownMDEmu_Iterate(const ClownMDEmu* const clownmdemu)
 	SyncZ80(clownmdemu, &cpu_callback_user_data, cycles_per_frame_mega_drive);
 	SyncMCDM68k(clownmdemu, &cpu_callback_user_data, cycles_per_frame_mega_cd);
 	SyncFM(&cpu_callback_user_data, cycles_per_frame_mega_drive);
+	FlushFM(&cpu_callback_user_data);
 	SyncPSG(&cpu_callback_user_data, cycles_per_frame_mega_drive);
 	SyncPCM(&cpu_callback_user_data, cycles_per_frame_mega_cd);
-	SyncCDDA(&cpu_callback_user_data, clownmdemu->configuration->general.tv_standard == CLOWNMDEMU_TV_STANDARD_PAL ? CLOWNMDEMU_DIVIDE_BY_PAL_FRAMERATE(44100) : CLOWNMDEMU_DIVIDE_BY_NTSC_FRAMERATE(44100));
+	SyncCDDA(&cpu_callback_user_data, clownmdemu->configuration->general.tv_standard == CLOWNMDEMU_TV_STANDARD_PAL ? CLOWNMDEMU_DIVIDE_BY_PAL_FRAMERATE(CLOWNMDEMU_CDDA_SAMPLE_RATE) : CLOWNMDEMU_DIVIDE_BY_NTSC_FRAMERATE(CLOWNMDEMU_CDDA_SAMPLE_RATE));
 
 	/* Fire IRQ1 if needed. */
 	/* TODO: This is a hack. Look into when this interrupt should actually be done. */
@@ -87,6 +87,8 @@ extern "C" {
 #define CLOWNMDEMU_PCM_SAMPLE_RATE_DIVIDER 0x180
 #define CLOWNMDEMU_PCM_SAMPLE_RATE (CLOWNMDEMU_MCD_M68K_CLOCK / CLOWNMDEMU_PCM_SAMPLE_RATE_DIVIDER)
 
+#define CLOWNMDEMU_CDDA_SAMPLE_RATE 44100
+
 /* The NTSC framerate is 59.94FPS (60 divided by 1.001) */
 #define CLOWNMDEMU_MULTIPLY_BY_NTSC_FRAMERATE(x) ((x) * (60 * 1000) / 1001)
 #define CLOWNMDEMU_DIVIDE_BY_NTSC_FRAMERATE(x) (((x) / 60) + ((x) / (60 * 1000)))
@@ -131,12 +133,21 @@ typedef enum ClownMDEmu_CDDAMode
 	CLOWNMDEMU_CDDA_PLAY_REPEAT
 } ClownMDEmu_CDDAMode;
 
+typedef enum ClownMDEmu_SoundChip
+{
+	CLOWNMDEMU_SOUND_CHIP_FM,
+	CLOWNMDEMU_SOUND_CHIP_PSG
+} ClownMDEmu_SoundChip;
+
 typedef struct ClownMDEmu_Configuration
 {
 	struct
 	{
 		ClownMDEmu_Region region;
 		ClownMDEmu_TVStandard tv_standard;
+		cc_bool m68k_idle_loop_skipping_disabled;
+		cc_bool mcd_m68k_idle_loop_skipping_disabled;
+		cc_bool z80_idle_loop_skipping_disabled;
 	} general;
 
 	VDP_Configuration vdp;
@@ -266,6 +277,10 @@ typedef struct ClownMDEmu_Callbacks
 	const cc_u8l* (*cd_sector_read)(void *user_data);
 	cc_bool (*cd_track_seeked)(void *user_data, cc_u16f track_index, ClownMDEmu_CDDAMode mode);
 	size_t (*cd_audio_read)(void *user_data, cc_s16l *sample_buffer, size_t total_frames);
+	/* Optional, and may be NULL. Reports every write to a sound chip, for logging. 'cycle' is the master clock cycle,
+	   relative to the start of the current frame. For the FM, 'port' and 'address' are the latched register,
+	   while, for the PSG, they are 0 and 'data' is the command. */
+	void (*sound_chip_written)(void *user_data, ClownMDEmu_SoundChip chip, cc_u8f port, cc_u8f address, cc_u8f data, cc_u32f cycle);
 } ClownMDEmu_Callbacks;
 
 typedef struct ClownMDEmu
@@ -121,148 +121,284 @@ static cc_s16f FM_Channel_MixSamples(const cc_s16f a, const cc_s16f b)
 	return CC_CLAMP(-0x100, 0xFF, a + b);
 }
 
-cc_s16f FM_Channel_GetSample(const FM_Channel* const channel)
+cc_bool FM_Channel_IsSilent(const FM_Channel* const channel)
 {
-	const FM_Operator* const operator1 = &channel->operators[0];
-	const FM_Operator* const operator2 = &channel->operators[2]; /* Yes, these really are swapped. */
-	const FM_Operator* const operator3 = &channel->operators[1];
-	const FM_Operator* const operator4 = &channel->operators[3];
-
-	cc_s16f feedback_modulation;
-	cc_s16f operator_1_sample;
-	cc_s16f operator_2_sample;
-	cc_s16f operator_3_sample;
-	cc_s16f operator_4_sample;
-	cc_s16f sample;
+	cc_u16f i;
 
-	/* Compute operator 1's self-feedback modulation. */
-	if (channel->state->feedback_divisor == 1 << (9 - 0))
-		feedback_modulation = 0;
-	else
-		feedback_modulation = (channel->state->operator_1_previous_samples[0] + channel->state->operator_1_previous_samples[1]) / channel->state->feedback_divisor;
+	for (i = 0; i < CC_COUNT_OF(channel->state->operators); ++i)
+		if (!FM_Operator_IsSilent(channel->operators[i].state))
+			return cc_false;
 
-	/* Feed the operators into each other to produce the final sample. */
-	/* Note that the operators output a 14-bit sample, meaning that, if all four are summed, then the result is a 16-bit sample,
-	   so there is no possibility of overflow. */
-	/* http://gendev.spritesmind.net/forum/viewtopic.php?p=5958#p5958 */
-	switch (channel->state->algorithm)
+	return cc_true;
+}
+
+void FM_Channel_Skip(const FM_Channel* const channel, const cc_u32f total_samples, const FM_Operator_EnvelopeClock* const envelope_clock)
+{
+	cc_u16f i;
+
+	for (i = 0; i < CC_COUNT_OF(channel->state->operators); ++i)
+		FM_Operator_Skip(channel->operators[i].state, total_samples, envelope_clock);
+
+	/* Operator 1 outputs 0 during the skipped samples, so the feedback values decay to 0 too. */
+	if (total_samples >= CC_COUNT_OF(channel->state->operator_1_previous_samples))
 	{
-		default:
-			/* Should not happen. */
-			assert(0);
-			/* Fallthrough */
-		case 0:
-			/* "Four serial connection mode". */
-			operator_1_sample = FM_Operator_Process(operator1, feedback_modulation);
-			operator_2_sample = FM_Operator_Process(operator2, operator_1_sample);
-			operator_3_sample = FM_Operator_Process(operator3, operator_2_sample);
-			operator_4_sample = FM_Operator_Process(operator4, operator_3_sample);
+		channel->state->operator_1_previous_samples[0] = 0;
+		channel->state->operator_1_previous_samples[1] = 0;
+	}
+	else if (total_samples != 0)
+	{
+		channel->state->operator_1_previous_samples[1] = channel->state->operator_1_previous_samples[0];
+		channel->state->operator_1_previous_samples[0] = 0;
+	}
+}
 
-			sample = FM_Channel_14BitTo9Bit(operator_4_sample);
+/* Yes, operators 2 and 3 really are swapped. */
+#define OPERATOR_1 0
+#define OPERATOR_2 2
+#define OPERATOR_3 1
+#define OPERATOR_4 3
 
-			break;
+#define PROCESS_OPERATOR(INDEX, PHASE_MODULATION) FM_Operator_Process(&channel->operators[INDEX], PHASE_MODULATION, envelope_update, envelope_cycle)
 
-		case 1:
-			/* "Three double modulation serial connection mode". */
-			operator_1_sample = FM_Operator_Process(operator1, feedback_modulation);
-			operator_2_sample = FM_Operator_Process(operator2, 0);
+/* Feed the operators into each other to produce the final sample. */
+/* Note that the operators output a 14-bit sample, meaning that, if all four are summed, then the result is a 16-bit sample,
+   so there is no possibility of overflow. */
+/* http://gendev.spritesmind.net/forum/viewtopic.php?p=5958#p5958 */
 
-			operator_3_sample = FM_Operator_Process(operator3, operator_1_sample + operator_2_sample);
-			operator_4_sample = FM_Operator_Process(operator4, operator_3_sample);
+static cc_s16f FM_Channel_Algorithm0(const FM_Channel* const channel, const cc_s16f feedback_modulation, const cc_bool envelope_update, const cc_u16f envelope_cycle, cc_s16f* const operator_1_sample_output)
+{
+	/* "Four serial connection mode". */
+	const cc_s16f operator_1_sample = PROCESS_OPERATOR(OPERATOR_1, feedback_modulation);
+	const cc_s16f operator_2_sample = PROCESS_OPERATOR(OPERATOR_2, operator_1_sample);
+	const cc_s16f operator_3_sample = PROCESS_OPERATOR(OPERATOR_3, operator_2_sample);
+	const cc_s16f operator_4_sample = PROCESS_OPERATOR(OPERATOR_4, operator_3_sample);
 
-			sample = FM_Channel_14BitTo9Bit(operator_4_sample);
+	*operator_1_sample_output = operator_1_sample;
 
-			break;
+	return FM_Channel_14BitTo9Bit(operator_4_sample);
+}
 
-		case 2:
-			/* "Double modulation mode (1)". */
-			operator_1_sample = FM_Operator_Process(operator1, feedback_modulation);
+static cc_s16f FM_Channel_Algorithm1(const FM_Channel* const channel, const cc_s16f feedback_modulation, const cc_bool envelope_update, const cc_u16f envelope_cycle, cc_s16f* const operator_1_sample_output)
+{
+	/* "Three double modulation serial connection mode". */
+	const cc_s16f operator_1_sample = PROCESS_OPERATOR(OPERATOR_1, feedback_modulation);
+	const cc_s16f operator_2_sample = PROCESS_OPERATOR(OPERATOR_2, 0);
 
-			operator_2_sample = FM_Operator_Process(operator2, 0);
-			operator_3_sample = FM_Operator_Process(operator3, operator_2_sample);
+	const cc_s16f operator_3_sample = PROCESS_OPERATOR(OPERATOR_3, operator_1_sample + operator_2_sample);
+	const cc_s16f operator_4_sample = PROCESS_OPERATOR(OPERATOR_4, operator_3_sample);
 
-			operator_4_sample = FM_Operator_Process(operator4, operator_1_sample + operator_3_sample);
+	*operator_1_sample_output = operator_1_sample;
 
-			sample = FM_Channel_14BitTo9Bit(operator_4_sample);
+	return FM_Channel_14BitTo9Bit(operator_4_sample);
+}
 
-			break;
+static cc_s16f FM_Channel_Algorithm2(const FM_Channel* const channel, const cc_s16f feedback_modulation, const cc_bool envelope_update, const cc_u16f envelope_cycle, cc_s16f* const operator_1_sample_output)
+{
+	/* "Double modulation mode (1)". */
+	const cc_s16f operator_1_sample = PROCESS_OPERATOR(OPERATOR_1, feedback_modulation);
 
-		case 3:
-			/* "Double modulation mode (2)". */
-			operator_1_sample = FM_Operator_Process(operator1, feedback_modulation);
-			operator_2_sample = FM_Operator_Process(operator2, operator_1_sample);
+	const cc_s16f operator_2_sample = PROCESS_OPERATOR(OPERATOR_2, 0);
+	const cc_s16f operator_3_sample = PROCESS_OPERATOR(OPERATOR_3, operator_2_sample);
 
-			operator_3_sample = FM_Operator_Process(operator3, 0);
+	const cc_s16f operator_4_sample = PROCESS_OPERATOR(OPERATOR_4, operator_1_sample + operator_3_sample);
 
-			operator_4_sample = FM_Operator_Process(operator4, operator_2_sample + operator_3_sample);
+	*operator_1_sample_output = operator_1_sample;
 
-			sample = FM_Channel_14BitTo9Bit(operator_4_sample);
+	return FM_Channel_14BitTo9Bit(operator_4_sample);
+}
 
-			break;
+static cc_s16f FM_Channel_Algorithm3(const FM_Channel* const channel, const cc_s16f feedback_modulation, const cc_bool envelope_update, const cc_u16f envelope_cycle, cc_s16f* const operator_1_sample_output)
+{
+	/* "Double modulation mode (2)". */
+	const cc_s16f operator_1_sample = PROCESS_OPERATOR(OPERATOR_1, feedback_modulation);
+	const cc_s16f operator_2_sample = PROCESS_OPERATOR(OPERATOR_2, operator_1_sample);
 
-		case 4:
-			/* "Two serial connection and two parallel modes". */
-			operator_1_sample = FM_Operator_Process(operator1, feedback_modulation);
-			operator_2_sample = FM_Operator_Process(operator2, operator_1_sample);
+	const cc_s16f operator_3_sample = PROCESS_OPERATOR(OPERATOR_3, 0);
 
-			operator_3_sample = FM_Operator_Process(operator3, 0);
-			operator_4_sample = FM_Operator_Process(operator4, operator_3_sample);
+	const cc_s16f operator_4_sample = PROCESS_OPERATOR(OPERATOR_4, operator_2_sample + operator_3_sample);
 
-			sample = FM_Channel_14BitTo9Bit(operator_2_sample);
-			sample = FM_Channel_MixSamples(sample, FM_Channel_14BitTo9Bit(operator_4_sample));
+	*operator_1_sample_output = operator_1_sample;
 
-			break;
+	return FM_Channel_14BitTo9Bit(operator_4_sample);
+}
 
-		case 5:
-			/* "Common modulation 3 parallel mode". */
-			operator_1_sample = FM_Operator_Process(operator1, feedback_modulation);
+static cc_s16f FM_Channel_Algorithm4(const FM_Channel* const channel, const cc_s16f feedback_modulation, const cc_bool envelope_update, const cc_u16f envelope_cycle, cc_s16f* const operator_1_sample_output)
+{
+	/* "Two serial connection and two parallel modes". */
+	const cc_s16f operator_1_sample = PROCESS_OPERATOR(OPERATOR_1, feedback_modulation);
+	const cc_s16f operator_2_sample = PROCESS_OPERATOR(OPERATOR_2, operator_1_sample);
 
-			operator_2_sample = FM_Operator_Process(operator2, operator_1_sample);
-			operator_3_sample = FM_Operator_Process(operator3, operator_1_sample);
-			operator_4_sample = FM_Operator_Process(operator4, operator_1_sample);
+	const cc_s16f operator_3_sample = PROCESS_OPERATOR(OPERATOR_3, 0);
+	const cc_s16f operator_4_sample = PROCESS_OPERATOR(OPERATOR_4, operator_3_sample);
 
-			sample = FM_Channel_14BitTo9Bit(operator_2_sample);
-			sample = FM_Channel_MixSamples(sample, FM_Channel_14BitTo9Bit(operator_3_sample));
-			sample = FM_Channel_MixSamples(sample, FM_Channel_14BitTo9Bit(operator_4_sample));
+	*operator_1_sample_output = operator_1_sample;
 
-			break;
+	return FM_Channel_MixSamples(FM_Channel_14BitTo9Bit(operator_2_sample), FM_Channel_14BitTo9Bit(operator_4_sample));
+}
 
-		case 6:
-			/* "Two serial connection + two sine mode". */
-			operator_1_sample = FM_Operator_Process(operator1, feedback_modulation);
-			operator_2_sample = FM_Operator_Process(operator2, operator_1_sample);
+static cc_s16f FM_Channel_Algorithm5(const FM_Channel* const channel, const cc_s16f feedback_modulation, const cc_bool envelope_update, const cc_u16f envelope_cycle, cc_s16f* const operator_1_sample_output)
+{
+	/* "Common modulation 3 parallel mode". */
+	const cc_s16f operator_1_sample = PROCESS_OPERATOR(OPERATOR_1, feedback_modulation);
 
-			operator_3_sample = FM_Operator_Process(operator3, 0);
+	const cc_s16f operator_2_sample = PROCESS_OPERATOR(OPERATOR_2, operator_1_sample);
+	const cc_s16f operator_3_sample = PROCESS_OPERATOR(OPERATOR_3, operator_1_sample);
+	const cc_s16f operator_4_sample = PROCESS_OPERATOR(OPERATOR_4, operator_1_sample);
 
-			operator_4_sample = FM_Operator_Process(operator4, 0);
+	cc_s16f sample;
 
-			sample = FM_Channel_14BitTo9Bit(operator_2_sample);
-			sample = FM_Channel_MixSamples(sample, FM_Channel_14BitTo9Bit(operator_3_sample));
-			sample = FM_Channel_MixSamples(sample, FM_Channel_14BitTo9Bit(operator_4_sample));
+	*operator_1_sample_output = operator_1_sample;
 
-			break;
+	sample = FM_Channel_14BitTo9Bit(operator_2_sample);
+	sample = FM_Channel_MixSamples(sample, FM_Channel_14BitTo9Bit(operator_3_sample));
+	sample = FM_Channel_MixSamples(sample, FM_Channel_14BitTo9Bit(operator_4_sample));
 
-		case 7:
-			/* "Four parallel sine synthesis mode". */
-			operator_1_sample = FM_Operator_Process(operator1, feedback_modulation);
+	return sample;
+}
 
-			operator_2_sample = FM_Operator_Process(operator2, 0);
+static cc_s16f FM_Channel_Algorithm6(const FM_Channel* const channel, const cc_s16f feedback_modulation, const cc_bool envelope_update, const cc_u16f envelope_cycle, cc_s16f* const operator_1_sample_output)
+{
+	/* "Two serial connection + two sine mode". */
+	const cc_s16f operator_1_sample = PROCESS_OPERATOR(OPERATOR_1, feedback_modulation);
+	const cc_s16f operator_2_sample = PROCESS_OPERATOR(OPERATOR_2, operator_1_sample);
 
-			operator_3_sample = FM_Operator_Process(operator3, 0);
+	const cc_s16f operator_3_sample = PROCESS_OPERATOR(OPERATOR_3, 0);
 
-			operator_4_sample = FM_Operator_Process(operator4, 0);
+	const cc_s16f operator_4_sample = PROCESS_OPERATOR(OPERATOR_4, 0);
 
-			sample = FM_Channel_14BitTo9Bit(operator_1_sample);
-			sample = FM_Channel_MixSamples(sample, FM_Channel_14BitTo9Bit(operator_2_sample));
-			sample = FM_Channel_MixSamples(sample, FM_Channel_14BitTo9Bit(operator_3_sample));
-			sample = FM_Channel_MixSamples(sample, FM_Channel_14BitTo9Bit(operator_4_sample));
+	cc_s16f sample;
 
-			break;
-	}
+	*operator_1_sample_output = operator_1_sample;
+
+	sample = FM_Channel_14BitTo9Bit(operator_2_sample);
+	sample = FM_Channel_MixSamples(sample, FM_Channel_14BitTo9Bit(operator_3_sample));
+	sample = FM_Channel_MixSamples(sample, FM_Channel_14BitTo9Bit(operator_4_sample));
+
+	return sample;
+}
+
+static cc_s16f FM_Channel_Algorithm7(const FM_Channel* const channel, const cc_s16f feedback_modulation, const cc_bool envelope_update, const cc_u16f envelope_cycle, cc_s16f* const operator_1_sample_output)
+{
+	/* "Four parallel sine synthesis mode". */
+	const cc_s16f operator_1_sample = PROCESS_OPERATOR(OPERATOR_1, feedback_modulation);
+
+	const cc_s16f operator_2_sample = PROCESS_OPERATOR(OPERATOR_2, 0);
+
+	const cc_s16f operator_3_sample = PROCESS_OPERATOR(OPERATOR_3, 0);
+
+	const cc_s16f operator_4_sample = PROCESS_OPERATOR(OPERATOR_4, 0);
+
+	cc_s16f sample;
+
+	*operator_1_sample_output = operator_1_sample;
 
-	/* Update the feedback values. */
-	channel->state->operator_1_previous_samples[1] = channel->state->operator_1_previous_samples[0];
-	channel->state->operator_1_previous_samples[0] = operator_1_sample;
+	sample = FM_Channel_14BitTo9Bit(operator_1_sample);
+	sample = FM_Channel_MixSamples(sample, FM_Channel_14BitTo9Bit(operator_2_sample));
+	sample = FM_Channel_MixSamples(sample, FM_Channel_14BitTo9Bit(operator_3_sample));
+	sample = FM_Channel_MixSamples(sample, FM_Channel_14BitTo9Bit(operator_4_sample));
 
 	return sample;
 }
+
+#undef PROCESS_OPERATOR
+#undef OPERATOR_4
+#undef OPERATOR_3
+#undef OPERATOR_2
+#undef OPERATOR_1
+
+/* Generates a function which renders a block of samples with a single algorithm, so that the algorithm
+   does not have to be selected for every sample, and the feedback and envelope clock can stay in locals. */
+#define FM_CHANNEL_DEFINE_GET_SAMPLES(NAME, ALGORITHM) \
+static void NAME(const FM_Channel* const channel, cc_s16l* const samples, const cc_u16f total_samples, const FM_Operator_EnvelopeClock* const envelope_clock) \
+{ \
+	const cc_s16f feedback_divisor = channel->state->feedback_divisor; \
+\
+	cc_s16f previous_sample = channel->state->operator_1_previous_samples[0]; \
+	cc_s16f previous_previous_sample = channel->state->operator_1_previous_samples[1]; \
+	cc_u16f envelope_countdown = envelope_clock->countdown; \
+	cc_u16f envelope_cycle_counter = envelope_clock->cycle_counter; \
+	cc_u16f i; \
+\
+	for (i = 0; i < total_samples; ++i) \
+	{ \
+		const cc_bool envelope_update = --envelope_countdown == 0; \
+		const cc_u16f envelope_cycle = envelope_cycle_counter; \
+\
+		cc_s16f feedback_modulation; \
+		cc_s16f operator_1_sample; \
+\
+		if (envelope_update) \
+		{ \
+			envelope_countdown = 3; \
+			++envelope_cycle_counter; \
+		} \
+\
+		/* Compute operator 1's self-feedback modulation. */ \
+		if (feedback_divisor == 1 << (9 - 0)) \
+			feedback_modulation = 0; \
+		else \
+			feedback_modulation = (previous_sample + previous_previous_sample) / feedback_divisor; \
+\
+		samples[i] = ALGORITHM(channel, feedback_modulation, envelope_update, envelope_cycle, &operator_1_sample); \
+\
+		/* Update the feedback values. */ \
+		previous_previous_sample = previous_sample; \
+		previous_sample = operator_1_sample; \
+	} \
+\
+	channel->state->operator_1_previous_samples[0] = previous_sample; \
+	channel->state->operator_1_previous_samples[1] = previous_previous_sample; \
+}
+
+FM_CHANNEL_DEFINE_GET_SAMPLES(FM_Channel_GetSamplesAlgorithm0, FM_Channel_Algorithm0)
+FM_CHANNEL_DEFINE_GET_SAMPLES(FM_Channel_GetSamplesAlgorithm1, FM_Channel_Algorithm1)
+FM_CHANNEL_DEFINE_GET_SAMPLES(FM_Channel_GetSamplesAlgorithm2, FM_Channel_Algorithm2)
+FM_CHANNEL_DEFINE_GET_SAMPLES(FM_Channel_GetSamplesAlgorithm3, FM_Channel_Algorithm3)
+FM_CHANNEL_DEFINE_GET_SAMPLES(FM_Channel_GetSamplesAlgorithm4, FM_Channel_Algorithm4)
+FM_CHANNEL_DEFINE_GET_SAMPLES(FM_Channel_GetSamplesAlgorithm5, FM_Channel_Algorithm5)
+FM_CHANNEL_DEFINE_GET_SAMPLES(FM_Channel_GetSamplesAlgorithm6, FM_Channel_Algorithm6)
+FM_CHANNEL_DEFINE_GET_SAMPLES(FM_Channel_GetSamplesAlgorithm7, FM_Channel_Algorithm7)
+
+#undef FM_CHANNEL_DEFINE_GET_SAMPLES
+
+void FM_Channel_GetSamples(const FM_Channel* const channel, cc_s16l* const samples, const cc_u16f total_samples, const FM_Operator_EnvelopeClock* const envelope_clock)
+{
+	switch (channel->state->algorithm)
+	{
+		default:
+			/* Should not happen. */
+			assert(0);
+			/* Fallthrough */
+		case 0:
+			FM_Channel_GetSamplesAlgorithm0(channel, samples, total_samples, envelope_clock);
+			break;
+
+		case 1:
+			FM_Channel_GetSamplesAlgorithm1(channel, samples, total_samples, envelope_clock);
+			break;
+
+		case 2:
+			FM_Channel_GetSamplesAlgorithm2(channel, samples, total_samples, envelope_clock);
+			break;
+
+		case 3:
+			FM_Channel_GetSamplesAlgorithm3(channel, samples, total_samples, envelope_clock);
+			break;
+
+		case 4:
+			FM_Channel_GetSamplesAlgorithm4(channel, samples, total_samples, envelope_clock);
+			break;
+
+		case 5:
+			FM_Channel_GetSamplesAlgorithm5(channel, samples, total_samples, envelope_clock);
+			break;
+
+		case 6:
+			FM_Channel_GetSamplesAlgorithm6(channel, samples, total_samples, envelope_clock);
+			break;
+
+		case 7:
+			FM_Channel_GetSamplesAlgorithm7(channel, samples, total_samples, envelope_clock);
+			break;
+	}
+}
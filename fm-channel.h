@@ -72,6 +72,11 @@ void FM_Channel_SetDecayRate(const FM_Channel *channel, cc_u16f operator_index,
 void FM_Channel_SetSustainRate(const FM_Channel *channel, cc_u16f operator_index, cc_u16f sustain_rate);
 void FM_Channel_SetSustainLevelAndReleaseRate(const FM_Channel *channel, cc_u16f operator_index, cc_u16f sustain_level, cc_u16f release_rate);
 
-cc_s16f FM_Channel_GetSample(const FM_Channel *channel);
+/* Returns whether every operator is silent, meaning that the channel outputs nothing but 0. */
+cc_bool FM_Channel_IsSilent(const FM_Channel *channel);
+/* Advances a silent channel by 'total_samples' without generating them. 'envelope_clock' is the state of the envelope clock at the first sample. */
+void FM_Channel_Skip(const FM_Channel *channel, cc_u32f total_samples, const FM_Operator_EnvelopeClock *envelope_clock);
+/* Outputs 9-bit samples. 'envelope_clock' is the state of the envelope clock at the first sample, and is not advanced. */
+void FM_Channel_GetSamples(const FM_Channel *channel, cc_s16l *samples, cc_u16f total_samples, const FM_Operator_EnvelopeClock *envelope_clock);
 
 #endif /* FM_CHANNEL_H */
@@ -123,11 +123,6 @@ void FM_Operator_State_Initialise(FM_Operator_State* const state)
 {
 	FM_Phase_State_Initialise(&state->phase);
 
-	/* Set envelope to update immediately. */
-	state->countdown = 1;
-
-	state->cycle_counter = 0;
-
 	state->delta_index = 0;
 	state->attenuation = 0x3FF;
 
@@ -143,6 +138,32 @@ void FM_Operator_State_Initialise(FM_Operator_State* const state)
 	state->key_on = cc_false;
 }
 
+void FM_Operator_EnvelopeClock_Initialise(FM_Operator_EnvelopeClock* const envelope_clock)
+{
+	/* Set envelopes to update immediately. */
+	envelope_clock->countdown = 1;
+	envelope_clock->cycle_counter = 0;
+}
+
+static cc_u32f GetEnvelopeClockUpdates(const FM_Operator_EnvelopeClock* const envelope_clock, const cc_u32f total_samples)
+{
+	/* The envelopes update once every three samples. */
+	if (total_samples < envelope_clock->countdown)
+		return 0;
+
+	return (total_samples - envelope_clock->countdown) / 3 + 1;
+}
+
+void FM_Operator_AdvanceEnvelopeClock(FM_Operator_EnvelopeClock* const envelope_clock, const cc_u32f total_samples)
+{
+	envelope_clock->cycle_counter += GetEnvelopeClockUpdates(envelope_clock, total_samples);
+
+	if (total_samples < envelope_clock->countdown)
+		envelope_clock->countdown -= total_samples;
+	else
+		envelope_clock->countdown = 3 - (total_samples - envelope_clock->countdown) % 3;
+}
+
 void FM_Operator_SetFrequency(FM_Operator_State* const state, const cc_u16f f_number_and_block)
 {
 	FM_Phase_SetFrequency(&state->phase, f_number_and_block);
@@ -219,36 +240,34 @@ void FM_Operator_SetSustainLevelAndReleaseRate(FM_Operator_State* const state, c
 	state->rates[FM_OPERATOR_ENVELOPE_MODE_RELEASE] = (release_rate << 1) | 1;
 }
 
-static cc_u16f GetEnvelopeDelta(FM_Operator_State* const state)
+static const cc_u16f envelope_cycle_bitmasks[0x40 / 4] = {
+	#define GENERATE_BITMASK(x) ((1 << (x)) - 1)
+	GENERATE_BITMASK(11),
+	GENERATE_BITMASK(10),
+	GENERATE_BITMASK(9),
+	GENERATE_BITMASK(8),
+	GENERATE_BITMASK(7),
+	GENERATE_BITMASK(6),
+	GENERATE_BITMASK(5),
+	GENERATE_BITMASK(4),
+	GENERATE_BITMASK(3),
+	GENERATE_BITMASK(2),
+	GENERATE_BITMASK(1),
+	GENERATE_BITMASK(0),
+	GENERATE_BITMASK(0),
+	GENERATE_BITMASK(0),
+	GENERATE_BITMASK(0),
+	GENERATE_BITMASK(0)
+	#undef GENERATE_BITMASK
+};
+
+static cc_u16f GetEnvelopeDelta(FM_Operator_State* const state, const cc_bool envelope_update, const cc_u16f envelope_cycle)
 {
-	if (--state->countdown == 0)
+	if (envelope_update)
 	{
-		static const cc_u16f cycle_bitmasks[0x40 / 4] = {
-			#define GENERATE_BITMASK(x) ((1 << (x)) - 1)
-			GENERATE_BITMASK(11),
-			GENERATE_BITMASK(10),
-			GENERATE_BITMASK(9),
-			GENERATE_BITMASK(8),
-			GENERATE_BITMASK(7),
-			GENERATE_BITMASK(6),
-			GENERATE_BITMASK(5),
-			GENERATE_BITMASK(4),
-			GENERATE_BITMASK(3),
-			GENERATE_BITMASK(2),
-			GENERATE_BITMASK(1),
-			GENERATE_BITMASK(0),
-			GENERATE_BITMASK(0),
-			GENERATE_BITMASK(0),
-			GENERATE_BITMASK(0),
-			GENERATE_BITMASK(0)
-			#undef GENERATE_BITMASK
-		};
-
 		const cc_u16f rate = CalculateRate(state);
 
-		state->countdown = 3;
-
-		if ((state->cycle_counter++ & cycle_bitmasks[rate / 4]) == 0)
+		if ((envelope_cycle & envelope_cycle_bitmasks[rate / 4]) == 0)
 		{
 			static const cc_u16f deltas[0x40][8] = {
 				{0, 0, 0, 0, 0, 0, 0, 0},
@@ -338,9 +357,9 @@ static void UpdateEnvelopeSSGEG(FM_Operator_State* const state)
 	}
 }
 
-static void UpdateEnvelopeADSR(FM_Operator_State* const state)
+static void UpdateEnvelopeADSR(FM_Operator_State* const state, const cc_bool envelope_update, const cc_u16f envelope_cycle)
 {
-	const cc_u16f delta = GetEnvelopeDelta(state);
+	const cc_u16f delta = GetEnvelopeDelta(state, envelope_update, envelope_cycle);
 	const cc_bool end_envelope = state->attenuation >= (state->ssgeg.enabled ? 0x200 : 0x3F0);
 
 	switch (state->envelope_mode)
@@ -385,15 +404,37 @@ static void UpdateEnvelopeADSR(FM_Operator_State* const state)
 	}
 }
 
-static cc_u16f UpdateEnvelope(FM_Operator_State* const state)
+cc_bool FM_Operator_IsSilent(const FM_Operator_State* const state)
+{
+	/* Once a keyed-off envelope has fully decayed, the only things which change are the phase and the delta index,
+	   and the attenuation is so high that the operator outputs nothing, regardless of its phase. */
+	/* SSG-EG is excluded because it keeps modifying the envelope even after it has decayed. */
+	return !state->key_on && !state->ssgeg.enabled && state->envelope_mode == FM_OPERATOR_ENVELOPE_MODE_RELEASE && state->attenuation == 0x3FF;
+}
+
+void FM_Operator_Skip(FM_Operator_State* const state, const cc_u32f total_samples, const FM_Operator_EnvelopeClock* const envelope_clock)
+{
+	/* Find how many of the envelope updates would have advanced the delta index. */
+	const cc_u16f cycle_interval = envelope_cycle_bitmasks[CalculateRate(state) / 4] + 1;
+	const cc_u32f first_cycle = envelope_clock->cycle_counter % cycle_interval;
+	const cc_u32f total_updates = GetEnvelopeClockUpdates(envelope_clock, total_samples);
+
+	assert(FM_Operator_IsSilent(state));
+
+	state->delta_index += CC_DIVIDE_CEILING(first_cycle + total_updates, cycle_interval) - CC_DIVIDE_CEILING(first_cycle, cycle_interval);
+
+	FM_Phase_IncrementMany(&state->phase, total_samples);
+}
+
+static cc_u16f UpdateEnvelope(FM_Operator_State* const state, const cc_bool envelope_update, const cc_u16f envelope_cycle)
 {
 	UpdateEnvelopeSSGEG(state);
-	UpdateEnvelopeADSR(state);
+	UpdateEnvelopeADSR(state, envelope_update, envelope_cycle);
 
 	return CC_MIN(0x3FF, GetSSGEGCorrectedAttenuation(state, !state->key_on) + state->total_level);
 }
 
-cc_s16f FM_Operator_Process(const FM_Operator* const fm_operator, const cc_s16f phase_modulation)
+static cc_s16f GenerateSample(const FM_Operator* const fm_operator, const cc_s16f phase_modulation, const cc_bool envelope_update, const cc_u16f envelope_cycle)
 {
 	/* TODO: https://gendev.spritesmind.net/forum/viewtopic.php?p=8908#p8908 */
 
@@ -401,7 +442,7 @@ cc_s16f FM_Operator_Process(const FM_Operator* const fm_operator, const cc_s16f
 	const cc_u16f phase = FM_Phase_Increment(&fm_operator->state->phase) >> 10;
 
 	/* Update and obtain attenuation (10-bit). */
-	const cc_u16f attenuation = UpdateEnvelope(fm_operator->state);
+	const cc_u16f attenuation = UpdateEnvelope(fm_operator->state, envelope_update, envelope_cycle);
 
 	/* Modulate the phase. */
 	/* The modulation is divided by two because up to two operators can provide modulation at once. */
@@ -430,3 +471,16 @@ cc_s16f FM_Operator_Process(const FM_Operator* const fm_operator, const cc_s16f
 	/* Return the 14-bit sample. */
 	return sample;
 }
+
+cc_s16f FM_Operator_Process(const FM_Operator* const fm_operator, const cc_s16f phase_modulation, const cc_bool envelope_update, const cc_u16f envelope_cycle)
+{
+	if (FM_Operator_IsSilent(fm_operator->state))
+	{
+		/* Only the phase and delta index would change, and the output would be 0 regardless. */
+		FM_Phase_Increment(&fm_operator->state->phase);
+		GetEnvelopeDelta(fm_operator->state, envelope_update, envelope_cycle);
+		return 0;
+	}
+
+	return GenerateSample(fm_operator, phase_modulation, envelope_update, envelope_cycle);
+}
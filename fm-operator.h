@@ -14,6 +14,13 @@ typedef enum FM_Operator_EnvelopeMode
 	FM_OPERATOR_ENVELOPE_MODE_RELEASE = 3
 } FM_Operator_EnvelopeMode;
 
+/* Drives every operator's envelope generator. */
+typedef struct FM_Operator_EnvelopeClock
+{
+	cc_u16l countdown;
+	cc_u16l cycle_counter;
+} FM_Operator_EnvelopeClock;
+
 typedef struct FM_Operator_Constant
 {
 	cc_u16l logarithmic_attenuation_sine_table[0x100];
@@ -24,10 +31,6 @@ typedef struct FM_Operator_State
 {
 	FM_Phase_State phase;
 
-	/* TODO: Make these two global. */
-	cc_u16l countdown;
-	cc_u16l cycle_counter;
-
 	cc_u16l delta_index;
 	cc_u16l attenuation;
 
@@ -59,6 +62,8 @@ typedef struct FM_Operator
 
 void FM_Operator_Constant_Initialise(FM_Operator_Constant *constant);
 void FM_Operator_State_Initialise(FM_Operator_State *state);
+void FM_Operator_EnvelopeClock_Initialise(FM_Operator_EnvelopeClock *envelope_clock);
+void FM_Operator_AdvanceEnvelopeClock(FM_Operator_EnvelopeClock *envelope_clock, cc_u32f total_samples);
 
 void FM_Operator_SetFrequency(FM_Operator_State *state, cc_u16f f_number_and_block);
 void FM_Operator_SetKeyOn(FM_Operator_State *state, cc_bool key_on);
@@ -70,6 +75,12 @@ void FM_Operator_SetDecayRate(FM_Operator_State *state, cc_u16f decay_rate);
 void FM_Operator_SetSustainRate(FM_Operator_State *state, cc_u16f sustain_rate);
 void FM_Operator_SetSustainLevelAndReleaseRate(FM_Operator_State *state, cc_u16f sustain_level, cc_u16f release_rate);
 
-cc_s16f FM_Operator_Process(const FM_Operator *fm_operator, cc_s16f phase_modulation);
+/* Returns whether the operator has fallen silent, and will remain so until it is written to. */
+cc_bool FM_Operator_IsSilent(const FM_Operator_State *state);
+/* Advances a silent operator by 'total_samples' without generating them. 'envelope_clock' is the state of the envelope clock at the first sample. */
+void FM_Operator_Skip(FM_Operator_State *state, cc_u32f total_samples, const FM_Operator_EnvelopeClock *envelope_clock);
+
+/* 'envelope_update' is whether the shared envelope clock ticked this sample, and 'envelope_cycle' is its cycle count when it did. */
+cc_s16f FM_Operator_Process(const FM_Operator *fm_operator, cc_s16f phase_modulation, cc_bool envelope_update, cc_u16f envelope_cycle);
 
 #endif /* FM_OPERATOR_H */
@@ -139,3 +139,8 @@ cc_u32f FM_Phase_Increment(FM_Phase_State* const phase)
 
 	return phase->position;
 }
+
+void FM_Phase_IncrementMany(FM_Phase_State* const phase, const cc_u32f total_increments)
+{
+	phase->position += phase->step * total_increments;
+}
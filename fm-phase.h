@@ -23,5 +23,6 @@ void FM_Phase_SetDetuneAndMultiplier(FM_Phase_State *phase, cc_u16f detune, cc_u
 
 void FM_Phase_Reset(FM_Phase_State *phase);
 cc_u32f FM_Phase_Increment(FM_Phase_State *phase);
+void FM_Phase_IncrementMany(FM_Phase_State *phase, cc_u32f total_increments);
 
 #endif /* FM_PHASE_H */
@@ -150,17 +150,26 @@ void FM_State_Initialise(FM_State* const state)
 
 	state->raw_timer_a_value = 0;
 
+	state->current_cycle = 0;
+
 	for (i = 0; i < CC_COUNT_OF(state->timers); ++i)
 	{
 		state->timers[i].value = FM_SAMPLE_RATE_DIVIDER; /* The timer expires when it goes BELOW 0, so this is a trick to emulate that. */
-		state->timers[i].counter = FM_SAMPLE_RATE_DIVIDER;
+		state->timers[i].overflow_cycle = state->current_cycle + FM_SAMPLE_RATE_DIVIDER;
 		state->timers[i].enabled = cc_false;
 	}
 
 	state->cached_address_27 = 0;
 	state->leftover_cycles = 0;
 	state->status = 0;
-	state->busy_flag_counter = 0;
+	state->busy_flag_end_cycle = 0;
+
+	FM_Operator_EnvelopeClock_Initialise(&state->envelope_clock);
+
+	state->write_queue.total_writes = 0;
+	state->write_queue.writes_applied = 0;
+	state->write_queue.total_frames = 0;
+	state->write_queue.frames_done = 0;
 }
 
 void FM_Parameters_Initialise(FM* const fm, const FM_Configuration* const configuration, const FM_Constant* const constant, FM_State* const state)
@@ -175,32 +184,35 @@ void FM_Parameters_Initialise(FM* const fm, const FM_Configuration* const config
 		FM_Channel_Parameters_Initialise(&fm->channels[i], &constant->channels, &state->channels[i].state);
 }
 
+static cc_u32f GetCyclesSince(const FM_State* const state, const cc_u32f cycle)
+{
+	return (state->current_cycle - cycle) & 0xFFFFFFFF;
+}
+
+static cc_bool HasCycleElapsed(const FM_State* const state, const cc_u32f cycle)
+{
+	/* The cycle counter wraps around, so cycles more than halfway around are treated as being in the future. */
+	return GetCyclesSince(state, cycle) < 0x80000000;
+}
+
 void FM_DoAddress(const FM* const fm, const cc_u8f port, const cc_u8f address)
 {
 	fm->state->port = port * 3;
 	fm->state->address = address;
 }
 
-void FM_DoData(const FM* const fm, const cc_u8f data)
+static void ApplyWrite(const FM* const fm, const cc_u8f port, const cc_u8f address, const cc_u8f data)
 {
 	FM_State* const state = fm->state;
 
-	/* Set BUSY flag. */
-	state->status |= 0x80;
-	/* The YM2612's BUSY flag is always active for exactly 32 internal cycles.
-	   If I remember correctly, the YM3438 actually gives the BUSY flag
-	   different durations based on the pending operation. */
-	/* TODO: YM3438 BUSY flag durations. */
-	state->busy_flag_counter = 32 * 6;
-
-	if (state->address < 0x30)
+	if (address < 0x30)
 	{
-		if (state->port == 0)
+		if (port == 0)
 		{
-			switch (state->address)
+			switch (address)
 			{
 				default:
-					LogMessage("Unrecognised FM address latched (0x%02" CC_PRIXFAST8 ")", state->address);
+					LogMessage("Unrecognised FM address latched (0x%02" CC_PRIXFAST8 ")", address);
 					break;
 
 				case 0x22:
@@ -210,47 +222,10 @@ void FM_DoData(const FM* const fm, const cc_u8f data)
 
 					break;
 
-				case 0x24:
-					/* Oddly, the YM2608 manual describes these timers being twice as fast as they are here. */
-					state->raw_timer_a_value &= 3;
-					state->raw_timer_a_value |= data << 2;
-					/* The '+1' is so that the timer expires when it tries to go BELOW 0. */
-					state->timers[0].value = FM_SAMPLE_RATE_DIVIDER * (1 + (0x400 - state->raw_timer_a_value));
-					break;
-
-				case 0x25:
-					state->raw_timer_a_value &= ~3;
-					state->raw_timer_a_value |= data & 3;
-					state->timers[0].value = FM_SAMPLE_RATE_DIVIDER * (1 + (0x400 - state->raw_timer_a_value));
-					break;
-
-				case 0x26:
-					state->timers[1].value = FM_SAMPLE_RATE_DIVIDER * (1 + (16 * (0x100 - data)));
-					break;
-
 				case 0x27:
 				{
 					const cc_bool fm3_per_operator_frequencies_enabled = (data & 0xC0) != 0;
 
-					cc_u8f i;
-
-					for (i = 0; i < CC_COUNT_OF(state->timers); ++i)
-					{
-						/* Only reload the timer on a rising edge. */
-						if ((data & (1 << (0 + i))) != 0 && (state->cached_address_27 & (1 << (0 + i))) == 0)
-							state->timers[i].counter = state->timers[i].value;
-
-						/* Enable the timer. */
-						state->timers[i].enabled = (data & (1 << (2 + i))) != 0;
-
-						/* Clear the 'timer expired' flag. */
-						if ((data & (1 << (4 + i))) != 0)
-							state->status &= ~(1 << i);
-					}
-
-					/* Cache the contents of this write for the above rising-edge detection. */
-					state->cached_address_27 = data;
-
 					if (state->channel_3_metadata.per_operator_frequencies_enabled != fm3_per_operator_frequencies_enabled)
 					{
 						state->channel_3_metadata.per_operator_frequencies_enabled = fm3_per_operator_frequencies_enabled;
@@ -261,8 +236,6 @@ void FM_DoData(const FM* const fm, const cc_u8f data)
 							FM_Channel_SetFrequency(&fm->channels[2], state->channel_3_metadata.frequencies[3]);
 					}
 
-					state->channel_3_metadata.csm_mode_enabled = (data & 0xC0) == 0x80;
-
 					break;
 				}
 
@@ -302,27 +275,27 @@ void FM_DoData(const FM* const fm, const cc_u8f data)
 	}
 	else
 	{
-		const cc_u16f channel_index = state->address & 3;
-		FM_ChannelMetadata* const channel_metadata = &state->channels[state->port + channel_index];
-		const FM_Channel* const channel = &fm->channels[state->port + channel_index];
+		const cc_u16f channel_index = address & 3;
+		FM_ChannelMetadata* const channel_metadata = &state->channels[port + channel_index];
+		const FM_Channel* const channel = &fm->channels[port + channel_index];
 
 		/* There is no fourth channel per slot. */
 		/* TODO: See how real hardware handles this. */
 		if (channel_index == 3)
 		{
-			LogMessage("Attempted to access invalid fourth FM slot channel (address was 0x%02" CC_PRIXFAST8 ")", state->address);
+			LogMessage("Attempted to access invalid fourth FM slot channel (address was 0x%02" CC_PRIXFAST8 ")", address);
 		}
 		else
 		{
-			if (state->address < 0xA0)
+			if (address < 0xA0)
 			{
 				/* Per-operator. */
-				const cc_u16f operator_index = (state->address >> 2) & 3;
+				const cc_u16f operator_index = (address >> 2) & 3;
 
-				switch (state->address / 0x10)
+				switch (address / 0x10)
 				{
 					default:
-						LogMessage("Unrecognised FM address latched (0x%02" CC_PRIXFAST8 ")", state->address);
+						LogMessage("Unrecognised FM address latched (0x%02" CC_PRIXFAST8 ")", address);
 						break;
 
 					case 0x30 / 0x10:
@@ -369,10 +342,10 @@ void FM_DoData(const FM* const fm, const cc_u8f data)
 			else
 			{
 				/* Per-channel. */
-				switch (state->address / 4)
+				switch (address / 4)
 				{
 					default:
-						LogMessage("Unrecognised FM address latched (0x%02" CC_PRIXFAST8 ")", state->address);
+						LogMessage("Unrecognised FM address latched (0x%02" CC_PRIXFAST8 ")", address);
 						break;
 
 					case 0xA0 / 4:
@@ -434,6 +407,107 @@ void FM_DoData(const FM* const fm, const cc_u8f data)
 	}
 }
 
+static void ApplyQueuedWrites(const FM* const fm, const cc_u32f frame)
+{
+	/* Applies every queued write which takes effect by the given frame. */
+	FM_State* const state = fm->state;
+
+	while (state->write_queue.writes_applied != state->write_queue.total_writes && state->write_queue.writes[state->write_queue.writes_applied].frame <= frame)
+	{
+		const FM_QueuedWrite* const write = &state->write_queue.writes[state->write_queue.writes_applied++];
+
+		ApplyWrite(fm, write->port, write->address, write->data);
+	}
+}
+
+static void QueueWrite(const FM* const fm, const cc_u8f port, const cc_u8f address, const cc_u8f data)
+{
+	FM_State* const state = fm->state;
+
+	FM_QueuedWrite *write;
+
+	/* 'FM_Update' makes sure that this does not happen, but just in case, apply the writes early instead of losing them. */
+	if (state->write_queue.total_writes == CC_COUNT_OF(state->write_queue.writes))
+	{
+		ApplyQueuedWrites(fm, 0xFFFFFFFF);
+		state->write_queue.total_writes = state->write_queue.writes_applied = 0;
+	}
+
+	write = &state->write_queue.writes[state->write_queue.total_writes++];
+	write->frame = state->write_queue.total_frames;
+	write->port = port;
+	write->address = address;
+	write->data = data;
+}
+
+void FM_DoData(const FM* const fm, const cc_u8f data)
+{
+	FM_State* const state = fm->state;
+
+	/* Set BUSY flag. */
+	state->status |= 0x80;
+	/* The YM2612's BUSY flag is always active for exactly 32 internal cycles.
+	   If I remember correctly, the YM3438 actually gives the BUSY flag
+	   different durations based on the pending operation. */
+	/* TODO: YM3438 BUSY flag durations. */
+	state->busy_flag_end_cycle = (state->current_cycle + 32 * 6) & 0xFFFFFFFF;
+
+	/* The timers affect the status register, so they must be updated immediately. Everything else is queued until the audio is generated. */
+	switch (state->port == 0 ? state->address : 0)
+	{
+		case 0x24:
+			/* Oddly, the YM2608 manual describes these timers being twice as fast as they are here. */
+			state->raw_timer_a_value &= 3;
+			state->raw_timer_a_value |= data << 2;
+			/* The '+1' is so that the timer expires when it tries to go BELOW 0. */
+			state->timers[0].value = FM_SAMPLE_RATE_DIVIDER * (1 + (0x400 - state->raw_timer_a_value));
+			break;
+
+		case 0x25:
+			state->raw_timer_a_value &= ~3;
+			state->raw_timer_a_value |= data & 3;
+			state->timers[0].value = FM_SAMPLE_RATE_DIVIDER * (1 + (0x400 - state->raw_timer_a_value));
+			break;
+
+		case 0x26:
+			state->timers[1].value = FM_SAMPLE_RATE_DIVIDER * (1 + (16 * (0x100 - data)));
+			break;
+
+		case 0x27:
+		{
+			cc_u8f i;
+
+			for (i = 0; i < CC_COUNT_OF(state->timers); ++i)
+			{
+				/* Only reload the timer on a rising edge. */
+				if ((data & (1 << (0 + i))) != 0 && (state->cached_address_27 & (1 << (0 + i))) == 0)
+					state->timers[i].overflow_cycle = (state->current_cycle + state->timers[i].value) & 0xFFFFFFFF;
+
+				/* Enable the timer. */
+				state->timers[i].enabled = (data & (1 << (2 + i))) != 0;
+
+				/* Clear the 'timer expired' flag. */
+				if ((data & (1 << (4 + i))) != 0)
+					state->status &= ~(1 << i);
+			}
+
+			/* Cache the contents of this write for the above rising-edge detection. */
+			state->cached_address_27 = data;
+
+			/* CSM mode is driven by timer A. */
+			state->channel_3_metadata.csm_mode_enabled = (data & 0xC0) == 0x80;
+
+			/* Channel 3's mode is applied with the rest of the audio. */
+			QueueWrite(fm, state->port, state->address, data);
+			break;
+		}
+
+		default:
+			QueueWrite(fm, state->port, state->address, data);
+			break;
+	}
+}
+
 static cc_s16f GetFinalSample(const FM* const fm, cc_s16f sample, const cc_bool enabled)
 {
 	/* From 9-bit to 16-bit. */
@@ -467,38 +541,127 @@ static cc_s16f GetFinalSample(const FM* const fm, cc_s16f sample, const cc_bool
 	return sample * fm_volume_multiplier / FM_VOLUME_DIVIDER;
 }
 
-void FM_OutputSamples(const FM* const fm, cc_s16l* const sample_buffer, const cc_u32f total_frames)
+static void GenerateSamples(const FM* const fm, cc_s16l* const sample_buffer, const cc_u32f stem_frame, const cc_u32f total_frames)
 {
 	FM_State* const state = fm->state;
 	const cc_s16f dac_sample = state->dac_sample;
 
-	const cc_s16l* const sample_buffer_end = &sample_buffer[total_frames * 2];
-
-	cc_u16f i;
+	cc_s16l *sample_buffer_pointer = sample_buffer;
+	cc_u32f stem_index = stem_frame * 2;
+	cc_u32f frames_remaining = total_frames;
 
-	for (i = 0; i < CC_COUNT_OF(state->channels); ++i)
+	/* The channels are rendered a block at a time, so that each one runs uninterrupted. */
+	while (frames_remaining != 0)
 	{
-		const FM_ChannelMetadata* const channel_metadata = &state->channels[i];
-		const FM_Channel* const channel = &fm->channels[i];
-		const cc_bool pan_left = channel_metadata->pan_left;
-		const cc_bool pan_right = channel_metadata->pan_right;
+		cc_s16l channel_samples[0x100];
+		const cc_u16f frames_to_do = CC_MIN(frames_remaining, CC_COUNT_OF(channel_samples));
 
-		const cc_bool is_dac = i == 5 && state->dac_enabled;
-		const cc_bool channel_disabled = is_dac ? fm->configuration->dac_channel_disabled : fm->configuration->fm_channels_disabled[i];
+		cc_u16f i;
 
-		cc_s16l *sample_buffer_pointer = sample_buffer;
+		for (i = 0; i < CC_COUNT_OF(state->channels); ++i)
+		{
+			const FM_ChannelMetadata* const channel_metadata = &state->channels[i];
+			const FM_Channel* const channel = &fm->channels[i];
+			const cc_bool pan_left = channel_metadata->pan_left;
+			const cc_bool pan_right = channel_metadata->pan_right;
 
-		if (channel_disabled)
-			continue;
+			const cc_bool is_dac = i == 5 && state->dac_enabled;
+			const cc_bool channel_disabled = is_dac ? fm->configuration->dac_channel_disabled : fm->configuration->fm_channels_disabled[i];
+			cc_s16l* const stem = fm->configuration->channel_stems[i] == NULL ? NULL : &fm->configuration->channel_stems[i][stem_index];
 
-		while (sample_buffer_pointer != sample_buffer_end)
-		{
-			const cc_s16f fm_sample = FM_Channel_GetSample(channel);
-			const cc_s16f sample = is_dac ? dac_sample : fm_sample;
+			cc_u16f j;
 
-			*sample_buffer_pointer++ += GetFinalSample(fm, sample, pan_left);
-			*sample_buffer_pointer++ += GetFinalSample(fm, sample, pan_right);
+			if (channel_disabled)
+			{
+				if (stem != NULL)
+					for (j = 0; j < frames_to_do * 2; ++j)
+						stem[j] = 0;
+
+				continue;
+			}
+
+			/* The channel still runs while the DAC is replacing its output. */
+			if (FM_Channel_IsSilent(channel))
+			{
+				/* The channel's output is constant, so there is no need to generate it. */
+				const cc_s16f sample = is_dac ? dac_sample : 0;
+				const cc_s16f left_sample = GetFinalSample(fm, sample, pan_left);
+				const cc_s16f right_sample = GetFinalSample(fm, sample, pan_right);
+
+				FM_Channel_Skip(channel, frames_to_do, &state->envelope_clock);
+
+				for (j = 0; j < frames_to_do; ++j)
+				{
+					sample_buffer_pointer[j * 2 + 0] += left_sample;
+					sample_buffer_pointer[j * 2 + 1] += right_sample;
+				}
+
+				if (stem != NULL)
+				{
+					for (j = 0; j < frames_to_do; ++j)
+					{
+						stem[j * 2 + 0] = left_sample;
+						stem[j * 2 + 1] = right_sample;
+					}
+				}
+			}
+			else
+			{
+				FM_Channel_GetSamples(channel, channel_samples, frames_to_do, &state->envelope_clock);
+
+				for (j = 0; j < frames_to_do; ++j)
+				{
+					const cc_s16f sample = is_dac ? dac_sample : channel_samples[j];
+					const cc_s16f left_sample = GetFinalSample(fm, sample, pan_left);
+					const cc_s16f right_sample = GetFinalSample(fm, sample, pan_right);
+
+					sample_buffer_pointer[j * 2 + 0] += left_sample;
+					sample_buffer_pointer[j * 2 + 1] += right_sample;
+
+					if (stem != NULL)
+					{
+						stem[j * 2 + 0] = left_sample;
+						stem[j * 2 + 1] = right_sample;
+					}
+				}
+			}
 		}
+
+		FM_Operator_AdvanceEnvelopeClock(&state->envelope_clock, frames_to_do);
+
+		sample_buffer_pointer += frames_to_do * 2;
+		stem_index += frames_to_do * 2;
+		frames_remaining -= frames_to_do;
+	}
+}
+
+void FM_OutputSamples(const FM* const fm, cc_s16l* const sample_buffer, const cc_u32f total_frames)
+{
+	FM_State* const state = fm->state;
+
+	cc_s16l *sample_buffer_pointer = sample_buffer;
+	cc_u32f frames_remaining = total_frames;
+
+	/* Generate the samples in chunks, applying each queued write at the frame where it was made. */
+	for (;;)
+	{
+		cc_u32f frames_to_do;
+
+		ApplyQueuedWrites(fm, state->write_queue.frames_done);
+
+		if (frames_remaining == 0)
+			break;
+
+		frames_to_do = frames_remaining;
+
+		if (state->write_queue.writes_applied != state->write_queue.total_writes)
+			frames_to_do = CC_MIN(frames_to_do, state->write_queue.writes[state->write_queue.writes_applied].frame - state->write_queue.frames_done);
+
+		GenerateSamples(fm, sample_buffer_pointer, total_frames - frames_remaining, frames_to_do);
+
+		sample_buffer_pointer += frames_to_do * 2;
+		frames_remaining -= frames_to_do;
+		state->write_queue.frames_done += frames_to_do;
 	}
 }
 
@@ -511,50 +674,79 @@ cc_u8f FM_Update(const FM* const fm, const cc_u32f cycles_to_do, void (* const f
 
 	state->leftover_cycles = (state->leftover_cycles + cycles_to_do) % FM_SAMPLE_RATE_DIVIDER;
 
-	if (total_frames != 0)
-		fm_audio_to_be_generated(user_data, total_frames);
+	/* Audio is generated in bulk by 'FM_Flush', rather than for every little update. */
+	state->write_queue.total_frames += total_frames;
 
-	/* Decrement the timers. */
+	state->current_cycle = (state->current_cycle + cycles_to_do) & 0xFFFFFFFF;
+
+	/* Rather than being decremented, the timers are compared against the time at which they overflow. */
 	for (timer_index = 0; timer_index < CC_COUNT_OF(state->timers); ++timer_index)
 	{
 		FM_Timer* const timer = &state->timers[timer_index];
 
-		if (timer->counter != 0)
+		if (HasCycleElapsed(state, timer->overflow_cycle))
 		{
-			timer->counter -= CC_MIN(timer->counter, cycles_to_do);
+			/* The timer may have overflowed several times since the last update. */
+			const cc_u32f total_overflows = 1 + GetCyclesSince(state, timer->overflow_cycle) / timer->value;
 
-			if (timer->counter == 0)
-			{
-				/* Set the 'timer expired' flag. */
-				state->status |= timer->enabled ? 1 << timer_index : 0;
+			/* Set the 'timer expired' flag. */
+			state->status |= timer->enabled ? 1 << timer_index : 0;
 
-				/* Reload the timer's counter. */
-				timer->counter = timer->value;
+			/* Reload the timer, keeping it in step with when it overflowed rather than with this update. */
+			timer->overflow_cycle = (timer->overflow_cycle + total_overflows * timer->value) & 0xFFFFFFFF;
 
-				/* Perform CSM key-on/key-off logic. */
-				if (state->channel_3_metadata.csm_mode_enabled && timer_index == 0)
-				{
-					cc_u8f operator_index;
-
-					for (operator_index = 0; operator_index < CC_COUNT_OF(fm->channels[2].operators); ++operator_index)
-					{
-						FM_Channel_SetKeyOn(&fm->channels[2], operator_index, cc_true);
-						FM_Channel_SetKeyOn(&fm->channels[2], operator_index, cc_false);
-					}
-				}
+			/* Perform CSM key-on/key-off logic. */
+			/* This keys all of channel 3's operators on and then off, just like these two writes do. */
+			if (state->channel_3_metadata.csm_mode_enabled && timer_index == 0)
+			{
+				QueueWrite(fm, 0, 0x28, 0xF2);
+				QueueWrite(fm, 0, 0x28, 0x02);
 			}
 		}
 	}
 
-	/* Decrement the BUSY flag counter. */
-	if (state->busy_flag_counter != 0)
-	{
-		state->busy_flag_counter -= CC_MIN(state->busy_flag_counter, cycles_to_do);
+	/* Clear BUSY flag if it has elapsed. */
+	if ((state->status & 0x80) != 0 && HasCycleElapsed(state, state->busy_flag_end_cycle))
+		state->status &= ~0x80;
 
-		/* Clear BUSY flag if the counter has elapsed. */
-		if (state->busy_flag_counter == 0)
-			state->status &= ~0x80;
-	}
+	/* Leave room for a write to follow this update, as well as the next update's CSM writes. */
+	if (CC_COUNT_OF(state->write_queue.writes) - state->write_queue.total_writes < 3)
+		FM_Flush(fm, fm_audio_to_be_generated, user_data);
 
 	return state->status;
 }
+
+void FM_Flush(const FM* const fm, void (* const fm_audio_to_be_generated)(const void *user_data, cc_u32f total_frames), const void* const user_data)
+{
+	FM_State* const state = fm->state;
+
+	if (state->write_queue.total_frames != 0)
+		fm_audio_to_be_generated(user_data, state->write_queue.total_frames);
+
+	/* Apply any writes which the audio did not reach. */
+	ApplyQueuedWrites(fm, 0xFFFFFFFF);
+
+	state->write_queue.total_writes = 0;
+	state->write_queue.writes_applied = 0;
+	state->write_queue.total_frames = 0;
+	state->write_queue.frames_done = 0;
+}
+
+cc_u32f FM_GetCyclesUntilNextEvent(const FM* const fm)
+{
+	const FM_State* const state = fm->state;
+
+	cc_u32f cycles;
+	cc_u8f timer_index;
+
+	cycles = 0xFFFFFFFF;
+
+	/* 'FM_Update' reloads every timer which has elapsed, so these are all in the future. */
+	for (timer_index = 0; timer_index < CC_COUNT_OF(state->timers); ++timer_index)
+		cycles = CC_MIN(cycles, (state->timers[timer_index].overflow_cycle - state->current_cycle) & 0xFFFFFFFF);
+
+	if ((state->status & 0x80) != 0)
+		cycles = CC_MIN(cycles, (state->busy_flag_end_cycle - state->current_cycle) & 0xFFFFFFFF);
+
+	return cycles;
+}
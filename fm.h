@@ -14,6 +14,9 @@
 /* 6 for the hardcoded prescale, 6 for the number of channels, and 4 for the number of operators per channel. */
 #define FM_SAMPLE_RATE_DIVIDER (6 * 6 * 4)
 
+/* How many register writes can be held back until the audio is generated. */
+#define FM_WRITE_QUEUE_LENGTH 0x200
+
 #define FM_PARAMETERS_INITIALISE(CONFIGURATION, CONSTANT, STATE) { \
 		(CONFIGURATION), \
 		(CONSTANT), \
@@ -65,6 +68,10 @@ typedef struct FM_Configuration
 	cc_bool fm_channels_disabled[6];
 	cc_bool dac_channel_disabled;
 	cc_bool ladder_effect_disabled;
+	/* Optional buffers which 'FM_OutputSamples' writes each channel's contribution to the mix to, for ripping
+	   individual channels. They are in the same format as the mix, and must be at least as large. Disabled
+	   channels are written as silence. Leave these NULL to not use them. */
+	cc_s16l *channel_stems[6];
 } FM_Configuration;
 
 typedef struct FM_Constant
@@ -75,10 +82,19 @@ typedef struct FM_Constant
 typedef struct FM_Timer
 {
 	cc_u32l value;
-	cc_u32l counter;
+	/* The timers always run; 'enabled' only controls whether they set the status flags. */
+	cc_u32l overflow_cycle;
 	cc_bool enabled;
 } FM_Timer;
 
+typedef struct FM_QueuedWrite
+{
+	cc_u32l frame; /* The write takes effect from this frame onwards. */
+	cc_u8l port;
+	cc_u8l address;
+	cc_u8l data;
+} FM_QueuedWrite;
+
 typedef struct FM_State
 {
 	FM_ChannelMetadata channels[6];
@@ -97,7 +113,18 @@ typedef struct FM_State
 	cc_u8l cached_address_27;
 	cc_u8l leftover_cycles;
 	cc_u8l status;
-	cc_u8l busy_flag_counter;
+	/* Timers and the BUSY flag expire at absolute cycles, measured against this. It wraps around. */
+	cc_u32l current_cycle;
+	cc_u32l busy_flag_end_cycle;
+	FM_Operator_EnvelopeClock envelope_clock; /* Shared by every operator. */
+	struct
+	{
+		FM_QueuedWrite writes[FM_WRITE_QUEUE_LENGTH];
+		cc_u16l total_writes;
+		cc_u16l writes_applied;
+		cc_u32l total_frames; /* Frames which have elapsed, but have not been generated yet. */
+		cc_u32l frames_done;
+	} write_queue;
 } FM_State;
 
 typedef struct FM
@@ -114,11 +141,17 @@ void FM_State_Initialise(FM_State *state);
 void FM_Parameters_Initialise(FM *fm, const FM_Configuration *configuration, const FM_Constant *constant, FM_State *state);
 
 void FM_DoAddress(const FM *fm, cc_u8f port, cc_u8f address);
+/* Writes which affect the audio are queued, to be applied when the audio is generated. 'FM_Update' must be called beforehand. */
 void FM_DoData(const FM *fm, cc_u8f data);
 
 void FM_OutputSamples(const FM *fm, cc_s16l *sample_buffer, cc_u32f total_frames);
-/* Updates the FM's internal state and outputs samples. */
+/* Updates the FM's internal state. Samples are not output until 'FM_Flush' is called, or the write queue fills up. */
 /* The samples are stereo and in signed 16-bit PCM format. */
 cc_u8f FM_Update(const FM *fm, cc_u32f cycles_to_do, void (*fm_audio_to_be_generated)(const void *user_data, cc_u32f total_frames), const void *user_data);
+/* Outputs all pending samples, and applies all queued writes. */
+void FM_Flush(const FM *fm, void (*fm_audio_to_be_generated)(const void *user_data, cc_u32f total_frames), const void *user_data);
+/* Returns how many cycles remain until a timer or the BUSY flag next elapses. */
+/* Until then, the status register is guaranteed to not change unless the FM is written to. */
+cc_u32f FM_GetCyclesUntilNextEvent(const FM *fm);
 
 #endif /* FM_H */
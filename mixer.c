@@ -0,0 +1,534 @@
+#include "mixer.h"
+
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+
+#include "clowncommon/clowncommon.h"
+
+#include "clownmdemu.h"
+#include "log.h"
+
+/* The sources do not run at exactly the rates that the mixer assumes (the PCM's clock is converted from the
+   Mega Drive's with a little rounding error, for instance), so a source's unplayed audio can slowly build up.
+   When it exceeds this many frames, the excess is discarded. */
+#define MIXER_MAXIMUM_BACKLOG 0x100
+
+static cc_u8f GetTotalChannels(const Mixer_Source source)
+{
+	return source == MIXER_SOURCE_PSG ? 1 : 2;
+}
+
+static void GetSourceRate(const Mixer_State* const state, const Mixer_Source source, cc_u32f* const clock, cc_u32f* const divider)
+{
+	const cc_u32f master_clock = state->pal_mode ? CLOWNMDEMU_MASTER_CLOCK_PAL : CLOWNMDEMU_MASTER_CLOCK_NTSC;
+
+	switch (source)
+	{
+		default:
+			/* Should not happen. */
+			assert(0);
+			/* Fallthrough */
+		case MIXER_SOURCE_FM:
+			*clock = master_clock;
+			*divider = CLOWNMDEMU_M68K_CLOCK_DIVIDER * FM_SAMPLE_RATE_DIVIDER;
+			break;
+
+		case MIXER_SOURCE_PSG:
+			*clock = master_clock;
+			*divider = CLOWNMDEMU_Z80_CLOCK_DIVIDER * CLOWNMDEMU_PSG_SAMPLE_RATE_DIVIDER;
+			break;
+
+		case MIXER_SOURCE_PCM:
+			*clock = CLOWNMDEMU_MCD_MASTER_CLOCK;
+			*divider = CLOWNMDEMU_MCD_M68K_CLOCK_DIVIDER * CLOWNMDEMU_PCM_SAMPLE_RATE_DIVIDER;
+			break;
+
+		case MIXER_SOURCE_CDDA:
+			/* The emulator outputs a whole number of CDDA frames per video frame, so the rate is not quite 44100Hz. */
+			if (state->pal_mode)
+			{
+				*clock = CLOWNMDEMU_DIVIDE_BY_PAL_FRAMERATE(CLOWNMDEMU_CDDA_SAMPLE_RATE) * 50;
+				*divider = 1;
+			}
+			else
+			{
+				*clock = CLOWNMDEMU_DIVIDE_BY_NTSC_FRAMERATE(CLOWNMDEMU_CDDA_SAMPLE_RATE) * 60 * 1000;
+				*divider = 1001;
+			}
+
+			break;
+	}
+}
+
+static void RecalculateRates(Mixer_State* const state)
+{
+	cc_u8f i;
+
+	for (i = 0; i < MIXER_SOURCE_TOTAL; ++i)
+	{
+		Mixer_SourceState* const source = &state->sources[i];
+
+		cc_u32f clock, divider, quotient, remainder;
+
+		GetSourceRate(state, (Mixer_Source)i, &clock, &divider);
+
+		/* The resampler steps through the input at 'clock / (divider * output_sample_rate)' frames per output frame. */
+		source->step_denominator = divider * state->output_sample_rate;
+
+		/* Apply the rate adjustment by dividing the clock by it. The adjustment is 16.16 fixed-point, so this is
+		   'clock * 0x10000 / rate_adjustment', done with long division to avoid overflowing 32 bits. */
+		quotient = clock / state->rate_adjustment;
+		remainder = clock % state->rate_adjustment;
+		quotient = (quotient << 8) + (remainder << 8) / state->rate_adjustment;
+		remainder = (remainder << 8) % state->rate_adjustment;
+		quotient = (quotient << 8) + (remainder << 8) / state->rate_adjustment;
+		source->step_numerator = quotient;
+
+		/* When downsampling, the kernel must be stretched so that its cutoff is the output's Nyquist frequency.
+		   The adjustment is ignored here, as it is far too small to matter. */
+		if (clock <= source->step_denominator)
+		{
+			source->kernel_scale = 0x4000;
+		}
+		else
+		{
+			cc_u8f shift = 0;
+
+			while ((clock >> shift) > 0xFFFF)
+				++shift;
+
+			source->kernel_scale = ((source->step_denominator >> shift) << 14) / (clock >> shift);
+		}
+
+		/* Keep the stretched kernel within the filter. At extremely low output sample rates, this lets some aliasing through. */
+		source->kernel_scale = CC_MAX(source->kernel_scale, CC_DIVIDE_CEILING((cc_u32f)MIXER_KERNEL_RADIUS * 0x4000, MIXER_MAXIMUM_KERNEL_RADIUS));
+		source->kernel_radius = CC_DIVIDE_CEILING((cc_u32f)MIXER_KERNEL_RADIUS * 0x4000, source->kernel_scale);
+	}
+}
+
+static void ResetSource(Mixer_State* const state, const Mixer_Source source_index)
+{
+	Mixer_SourceState* const source = &state->sources[source_index];
+
+	if (source_index == MIXER_SOURCE_PSG)
+	{
+		Mixer_StepState* const steps = &state->psg_steps;
+		cc_u32f i;
+
+		source->total_frames = 0;
+
+		for (i = 0; i < CC_COUNT_OF(steps->impulses); ++i)
+			steps->impulses[i] = 0;
+
+		steps->accumulator = 0;
+		/* Leave room for the impulses to spread to the left. */
+		steps->time = MIXER_KERNEL_RADIUS - 1;
+		steps->time_fraction = 0;
+		steps->previous_level = 0;
+	}
+	else
+	{
+		/* Prefill the buffer with silence, so that the kernel has input to its left to begin with. */
+		source->total_frames = source->kernel_radius - 1;
+		memset(source->buffer, 0, source->total_frames * GetTotalChannels(source_index) * sizeof(*source->buffer));
+
+		source->position = source->kernel_radius - 1;
+		source->position_fraction = 0;
+	}
+
+	source->active = cc_false;
+}
+
+static cc_s32f GetKernelIntegral(const Mixer_Constant* const constant, const cc_u32f end)
+{
+	/* This uses the trapezoidal rule, and is doubled to avoid fractions. */
+	cc_s32f total = (end < CC_COUNT_OF(constant->kernel) ? constant->kernel[end] : 0) - constant->kernel[0];
+	cc_u32f i;
+
+	for (i = 0; i < end; ++i)
+		total += constant->kernel[i] * 2;
+
+	return total;
+}
+
+static cc_s32f GetStepResponse(const Mixer_Constant* const constant, const cc_s32f distance)
+{
+	/* This is the integral of the whole kernel up to 'distance', scaled so that 0x2000 is unity. */
+	const cc_s32f half_total = GetKernelIntegral(constant, CC_COUNT_OF(constant->kernel));
+	const cc_s32f total = distance < 0 ? half_total - GetKernelIntegral(constant, CC_MIN(-distance, (cc_s32f)CC_COUNT_OF(constant->kernel))) : half_total + GetKernelIntegral(constant, CC_MIN(distance, (cc_s32f)CC_COUNT_OF(constant->kernel)));
+
+	return (cc_s32f)floor((double)total * 0x2000 / (half_total * 2) + 0.5);
+}
+
+void Mixer_Constant_Initialise(Mixer_Constant* const constant)
+{
+	cc_u16f i;
+
+	/* Generate a Lanczos kernel. */
+	for (i = 0; i < CC_COUNT_OF(constant->kernel); ++i)
+	{
+		const double x = (double)i / MIXER_KERNEL_RESOLUTION;
+		const double sinc_x = i == 0 ? 1.0 : sin(CC_PI * x) / (CC_PI * x);
+		const double sinc_x_over_radius = i == 0 ? 1.0 : sin(CC_PI * x / MIXER_KERNEL_RADIUS) / (CC_PI * x / MIXER_KERNEL_RADIUS);
+
+		constant->kernel[i] = (cc_s16l)floor(sinc_x * sinc_x_over_radius * 0x4000 + 0.5);
+	}
+
+	/* Generate the impulses which the PSG's steps are converted to. Integrating the kernel's samples does not
+	   produce samples of the kernel's integral, so the impulses are made by differentiating the latter instead. */
+	for (i = 0; i < CC_COUNT_OF(constant->impulses); ++i)
+	{
+		cc_u16f tap;
+
+		for (tap = 0; tap < CC_COUNT_OF(constant->impulses[i]); ++tap)
+		{
+			const cc_s32f distance = ((cc_s32f)tap + 1 - MIXER_KERNEL_RADIUS) * MIXER_KERNEL_RESOLUTION - (cc_s32f)i;
+
+			/* The last tap absorbs the kernel's truncated tail, so that every phase sums to exactly 0x2000.
+			   Otherwise, the error would build up when the impulses are integrated. */
+			const cc_s32f after = tap == CC_COUNT_OF(constant->impulses[i]) - 1 ? 0x2000 : GetStepResponse(constant, distance);
+			const cc_s32f before = GetStepResponse(constant, distance - MIXER_KERNEL_RESOLUTION);
+
+			constant->impulses[i][tap] = (cc_s16l)(after - before);
+		}
+	}
+}
+
+void Mixer_State_Initialise(Mixer_State* const state, const cc_u32f output_sample_rate, const cc_bool pal_mode)
+{
+	cc_u8f i;
+
+	state->output_sample_rate = output_sample_rate;
+	state->rate_adjustment = 0x10000;
+	state->pal_mode = pal_mode;
+
+	/* The filters are made by 'Mixer_Output', as the constant is not available here. */
+	for (i = 0; i < MIXER_SOURCE_TOTAL; ++i)
+		state->sources[i].filter_scale = 0;
+
+	RecalculateRates(state);
+
+	for (i = 0; i < MIXER_SOURCE_TOTAL; ++i)
+		ResetSource(state, (Mixer_Source)i);
+}
+
+void Mixer_Parameters_Initialise(Mixer* const mixer, const Mixer_Configuration* const configuration, const Mixer_Constant* const constant, Mixer_State* const state)
+{
+	mixer->configuration = configuration;
+	mixer->constant = constant;
+	mixer->state = state;
+}
+
+void Mixer_SetRateAdjustment(const Mixer* const mixer, const cc_u32f adjustment)
+{
+	Mixer_State* const state = mixer->state;
+
+	state->rate_adjustment = CC_CLAMP(0x8000, 0x20000, adjustment);
+
+	RecalculateRates(state);
+
+	/* The PSG's position is relative to the numerator, which has just changed. */
+	state->psg_steps.time_fraction = CC_MIN(state->psg_steps.time_fraction, state->sources[MIXER_SOURCE_PSG].step_numerator - 1);
+}
+
+cc_s16l* Mixer_AllocateFrames(const Mixer* const mixer, const Mixer_Source source, const size_t total_frames)
+{
+	Mixer_SourceState* const source_state = &mixer->state->sources[source];
+	const cc_u8f total_channels = GetTotalChannels(source);
+
+	cc_s16l *buffer;
+
+	if (total_frames > MIXER_BUFFER_FRAMES - source_state->total_frames)
+	{
+		LogMessage("Mixer buffer overflowed: 'Mixer_Output' is not being called often enough");
+		ResetSource(mixer->state, source);
+	}
+
+	assert(total_frames <= MIXER_BUFFER_FRAMES - source_state->total_frames);
+
+	buffer = &source_state->buffer[source_state->total_frames * total_channels];
+	memset(buffer, 0, total_frames * total_channels * sizeof(*buffer));
+
+	source_state->total_frames += total_frames;
+	source_state->active = cc_true;
+
+	return buffer;
+}
+
+static void MakeFilter(const Mixer_Constant* const constant, Mixer_SourceState* const source)
+{
+	const cc_u32f kernel_radius = source->kernel_radius;
+	const cc_u32f kernel_scale = source->kernel_scale;
+
+	cc_u32f phase, tap;
+
+	for (phase = 0; phase < MIXER_KERNEL_RESOLUTION; ++phase)
+	{
+		cc_s16l* const taps = source->filter[phase];
+
+		cc_s32f total, normalised_total;
+
+		total = 0;
+
+		for (tap = 0; tap < kernel_radius * 2; ++tap)
+		{
+			const cc_u32f distance = tap < kernel_radius ? (kernel_radius - 1 - tap) * MIXER_KERNEL_RESOLUTION + phase : (tap + 1 - kernel_radius) * MIXER_KERNEL_RESOLUTION - phase;
+			const cc_u32f kernel_index = distance * kernel_scale / 0x4000;
+
+			taps[tap] = kernel_index < CC_COUNT_OF(constant->kernel) ? constant->kernel[kernel_index] : 0;
+			total += taps[tap];
+		}
+
+		/* Scale the taps so that they sum to unity. Stretching the kernel makes it cover more input frames,
+		   and sampling it at a different phase changes its sum slightly, so this is different for every phase. */
+		normalised_total = 0;
+
+		for (tap = 0; tap < kernel_radius * 2; ++tap)
+		{
+			taps[tap] = (cc_s16l)((cc_s32f)taps[tap] * 0x4000 / total);
+			normalised_total += taps[tap];
+		}
+
+		/* The tap which is nearest to the centre absorbs the rounding error. */
+		taps[kernel_radius - 1 + (phase >= MIXER_KERNEL_RESOLUTION / 2)] += (cc_s16l)(0x4000 - normalised_total);
+	}
+
+	source->filter_scale = kernel_scale;
+}
+
+static void ResampleFrame(Mixer_SourceState* const source, const Mixer_Source source_index, cc_s32f* const output)
+{
+	const cc_u8f total_channels = GetTotalChannels(source_index);
+	const cc_u32f kernel_radius = source->kernel_radius;
+	/* How far the output frame is past the input frame at 'position', in 1/MIXER_KERNEL_RESOLUTION frames. */
+	const cc_u32f phase = source->position_fraction / CC_DIVIDE_CEILING(source->step_denominator, MIXER_KERNEL_RESOLUTION);
+	const cc_s16l* const taps = source->filter[phase];
+	const cc_s16l* const input = &source->buffer[(source->position + 1 - kernel_radius) * total_channels];
+
+	cc_s32f totals[2] = {0, 0};
+	cc_u32f tap;
+	cc_u8f channel;
+
+	for (tap = 0; tap < kernel_radius * 2; ++tap)
+		for (channel = 0; channel < total_channels; ++channel)
+			totals[channel] += (cc_s32f)input[tap * total_channels + channel] * taps[tap];
+
+	for (channel = 0; channel < total_channels; ++channel)
+		output[channel] = CC_CLAMP(-0x8000, 0x7FFF, totals[channel] / 0x4000);
+
+	/* Advance to the next output frame. */
+	source->position_fraction += source->step_numerator;
+	source->position += source->position_fraction / source->step_denominator;
+	source->position_fraction %= source->step_denominator;
+}
+
+static void ConvertPSGStepsToImpulses(const Mixer* const mixer)
+{
+	Mixer_SourceState* const source = &mixer->state->sources[MIXER_SOURCE_PSG];
+	Mixer_StepState* const steps = &mixer->state->psg_steps;
+	const cc_u32f phase_divisor = CC_DIVIDE_CEILING(source->step_numerator, MIXER_KERNEL_RESOLUTION);
+
+	cc_u32f i;
+
+	/* Impulses are only needed when the level changes, which is far less often than once per output frame. */
+	for (i = 0; i < source->total_frames; ++i)
+	{
+		const cc_s16f level = source->buffer[i];
+
+		/* This can only happen at extremely high output sample rates. */
+		if (steps->time + MIXER_KERNEL_RADIUS >= CC_COUNT_OF(steps->impulses))
+		{
+			LogMessage("Mixer buffer overflowed: 'Mixer_Output' is not being called often enough");
+			break;
+		}
+
+		if (level != steps->previous_level)
+		{
+			const cc_s32f delta = level - steps->previous_level;
+			const cc_s16l* const impulse = mixer->constant->impulses[steps->time_fraction / phase_divisor];
+			cc_s32l* const destination = &steps->impulses[steps->time + 1 - MIXER_KERNEL_RADIUS];
+
+			cc_u8f tap;
+
+			for (tap = 0; tap < MIXER_KERNEL_RADIUS * 2; ++tap)
+				destination[tap] += delta * impulse[tap];
+
+			steps->previous_level = level;
+		}
+
+		/* Advance to the next input frame. */
+		steps->time_fraction += source->step_denominator;
+		steps->time += steps->time_fraction / source->step_numerator;
+		steps->time_fraction %= source->step_numerator;
+	}
+
+	source->total_frames = 0;
+}
+
+static void DiscardPSGImpulses(Mixer_StepState* const steps, const cc_u32f total_frames)
+{
+	/* The last impulse to have been added reaches as far as 'time + MIXER_KERNEL_RADIUS'. */
+	const cc_u32f frames_remaining = CC_MIN(steps->time + MIXER_KERNEL_RADIUS + 1, CC_COUNT_OF(steps->impulses)) - total_frames;
+
+	cc_u32f i;
+
+	memmove(steps->impulses, &steps->impulses[total_frames], frames_remaining * sizeof(*steps->impulses));
+
+	for (i = frames_remaining; i < frames_remaining + total_frames; ++i)
+		steps->impulses[i] = 0;
+
+	steps->time -= total_frames;
+}
+
+#ifndef NDEBUG
+static cc_bool PSGLevelIsConsistent(const Mixer_StepState* const steps)
+{
+	/* Every impulse sums to 0x2000, so integrating the ones which have yet to be output must bring the accumulator to
+	   exactly the current level. If it does not, then a tap has been lost, and the output has picked up a DC offset. */
+	const cc_u32f total_impulses = CC_MIN(steps->time + MIXER_KERNEL_RADIUS + 1, CC_COUNT_OF(steps->impulses));
+
+	cc_s32f total = steps->accumulator;
+	cc_u32f i;
+
+	for (i = 0; i < total_impulses; ++i)
+		total += steps->impulses[i];
+
+	return total == (cc_s32f)steps->previous_level * 0x2000;
+}
+#endif
+
+void Mixer_Output(const Mixer* const mixer, const Mixer_OutputCallback callback, const void* const user_data)
+{
+	Mixer_State* const state = mixer->state;
+
+	cc_s16l output_buffer[0x100 * 2];
+	cc_u16f output_frames = 0;
+	cc_u32f frames_mixed = 0;
+	cc_bool any_active = cc_false;
+	cc_u8f i;
+
+	/* Sources which were not given any audio are silent, so discard whatever they had left over. */
+	for (i = 0; i < MIXER_SOURCE_TOTAL; ++i)
+	{
+		if (state->sources[i].active)
+			any_active = cc_true;
+		else
+			ResetSource(state, (Mixer_Source)i);
+	}
+
+	if (!any_active)
+		return;
+
+	if (state->sources[MIXER_SOURCE_PSG].active)
+		ConvertPSGStepsToImpulses(mixer);
+
+	for (i = 0; i < MIXER_SOURCE_TOTAL; ++i)
+	{
+		Mixer_SourceState* const source = &state->sources[i];
+
+		if (i != MIXER_SOURCE_PSG && source->active && source->filter_scale != source->kernel_scale)
+			MakeFilter(mixer->constant, source);
+	}
+
+	for (;;)
+	{
+		cc_s32f mixed_frame[2] = {0, 0};
+		cc_bool enough_input = cc_true;
+		cc_u8f channel;
+
+		/* Every source must have enough input for the kernel to cover, otherwise the sources would go out of sync. */
+		for (i = 0; i < MIXER_SOURCE_TOTAL; ++i)
+		{
+			const Mixer_SourceState* const source = &state->sources[i];
+
+			if (!source->active)
+				continue;
+
+			/* The PSG's output frames are complete once no future impulse can reach them. */
+			if (i == MIXER_SOURCE_PSG ? frames_mixed + MIXER_KERNEL_RADIUS > state->psg_steps.time : source->position + source->kernel_radius >= source->total_frames)
+				enough_input = cc_false;
+		}
+
+		if (!enough_input)
+			break;
+
+		for (i = 0; i < MIXER_SOURCE_TOTAL; ++i)
+		{
+			Mixer_SourceState* const source = &state->sources[i];
+
+			if (source->active)
+			{
+				cc_s32f source_frame[2];
+
+				if (i == MIXER_SOURCE_PSG)
+				{
+					state->psg_steps.accumulator += state->psg_steps.impulses[frames_mixed];
+
+					/* The PSG is mono, so it is output to both speakers. */
+					source_frame[0] = source_frame[1] = state->psg_steps.accumulator / 0x2000;
+				}
+				else
+				{
+					ResampleFrame(source, (Mixer_Source)i, source_frame);
+				}
+
+				for (channel = 0; channel < CC_COUNT_OF(mixed_frame); ++channel)
+					mixed_frame[channel] += source_frame[channel] * mixer->configuration->gains[i] / 0x100;
+			}
+		}
+
+		for (channel = 0; channel < CC_COUNT_OF(mixed_frame); ++channel)
+			output_buffer[output_frames * 2 + channel] = CC_CLAMP(-0x8000, 0x7FFF, mixed_frame[channel]);
+
+		++frames_mixed;
+
+		if (++output_frames == CC_COUNT_OF(output_buffer) / 2)
+		{
+			callback((void*)user_data, output_buffer, output_frames);
+			output_frames = 0;
+		}
+	}
+
+	if (output_frames != 0)
+		callback((void*)user_data, output_buffer, output_frames);
+
+	/* Discard the input which the kernel has moved past, keeping just enough for it to cover on its left. */
+	for (i = 0; i < MIXER_SOURCE_TOTAL; ++i)
+	{
+		Mixer_SourceState* const source = &state->sources[i];
+		const cc_u8f total_channels = GetTotalChannels((Mixer_Source)i);
+
+		if (source->active && i == MIXER_SOURCE_PSG)
+		{
+			Mixer_StepState* const steps = &state->psg_steps;
+			const cc_u32f frames_available = steps->time + 1 - MIXER_KERNEL_RADIUS;
+
+			/* Skipped frames still have to be integrated, to keep the waveform's level correct. */
+			if (frames_available > frames_mixed + MIXER_MAXIMUM_BACKLOG)
+				while (frames_mixed != frames_available)
+					steps->accumulator += steps->impulses[frames_mixed++];
+
+			DiscardPSGImpulses(steps, frames_mixed);
+			assert(PSGLevelIsConsistent(steps));
+			source->active = cc_false;
+		}
+		else if (source->active)
+		{
+			const cc_u32f frames_needed = source->position + source->kernel_radius;
+
+			cc_u32f frames_to_discard;
+
+			if (source->total_frames > frames_needed + MIXER_MAXIMUM_BACKLOG)
+				source->position += source->total_frames - frames_needed;
+
+			frames_to_discard = source->position + 1 - source->kernel_radius;
+
+			memmove(source->buffer, &source->buffer[frames_to_discard * total_channels], (source->total_frames - frames_to_discard) * total_channels * sizeof(*source->buffer));
+
+			source->total_frames -= frames_to_discard;
+			source->position -= frames_to_discard;
+			source->active = cc_false;
+		}
+	}
+}
@@ -0,0 +1,113 @@
+#ifndef MIXER_H
+#define MIXER_H
+
+#include <stddef.h>
+
+#include "clowncommon/clowncommon.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The number of zero-crossings on either side of the resampling kernel's centre. */
+#define MIXER_KERNEL_RADIUS 8
+/* The number of kernel entries between each zero-crossing. */
+#define MIXER_KERNEL_RESOLUTION 0x100
+/* How far, in input frames, a stretched kernel can reach on either side of its centre. This is enough for the FM
+   to be downsampled to below 9kHz. At lower output sample rates, the kernel is not stretched as far as it should be. */
+#define MIXER_MAXIMUM_KERNEL_RADIUS 0x30
+/* How many frames each source can hold between calls to 'Mixer_Output'.
+   This is enough for over a video frame of PSG audio, which has the highest sample rate. */
+#define MIXER_BUFFER_FRAMES 0x2000
+
+typedef enum Mixer_Source
+{
+	MIXER_SOURCE_FM,
+	MIXER_SOURCE_PSG,
+	MIXER_SOURCE_PCM,
+	MIXER_SOURCE_CDDA,
+	MIXER_SOURCE_TOTAL
+} Mixer_Source;
+
+typedef struct Mixer_Configuration
+{
+	/* 0x100 is unity gain. */
+	cc_u16l gains[MIXER_SOURCE_TOTAL];
+} Mixer_Configuration;
+
+typedef struct Mixer_Constant
+{
+	/* One half of a Lanczos kernel, in 2.14 fixed-point format. */
+	cc_s16l kernel[MIXER_KERNEL_RADIUS * MIXER_KERNEL_RESOLUTION];
+	/* The differentiated step response of the full kernel at each phase. Each phase sums to exactly 0x2000. */
+	cc_s16l impulses[MIXER_KERNEL_RESOLUTION][MIXER_KERNEL_RADIUS * 2];
+} Mixer_Constant;
+
+typedef struct Mixer_SourceState
+{
+	cc_s16l buffer[MIXER_BUFFER_FRAMES * 2];
+	cc_u32l total_frames;
+	/* The resampler's position in the buffer is 'position + position_fraction / step_denominator' frames. */
+	cc_u32l position;
+	cc_u32l position_fraction;
+	cc_u32l step_numerator;
+	cc_u32l step_denominator;
+	cc_u16l kernel_scale; /* 2.14 fixed-point. Below 1.0 when downsampling, to move the cutoff down to the output's Nyquist frequency. */
+	cc_u16l kernel_radius; /* In input frames. */
+	/* The stretched kernel's taps at each phase, in 2.14 fixed-point format. Each phase sums to exactly 0x4000, so that
+	   the output does not ripple along with the phase. This is remade whenever the rate changes 'kernel_scale'. */
+	cc_s16l filter[MIXER_KERNEL_RESOLUTION][MIXER_MAXIMUM_KERNEL_RADIUS * 2];
+	cc_u16l filter_scale; /* The 'kernel_scale' which 'filter' was made for, or 0 if it has not been made yet. */
+	cc_bool active;
+} Mixer_SourceState;
+
+/* The PSG's output only ever changes in steps, so, rather than being resampled, each step is added to
+   the output as a band-limited impulse, and the impulses are then integrated to produce the waveform. */
+typedef struct Mixer_StepState
+{
+	cc_s32l impulses[MIXER_BUFFER_FRAMES + MIXER_KERNEL_RADIUS * 2];
+	cc_s32l accumulator;
+	/* The next input frame lands on output frame 'time + time_fraction / step_numerator'. */
+	cc_u32l time;
+	cc_u32l time_fraction;
+	cc_s16l previous_level;
+} Mixer_StepState;
+
+typedef struct Mixer_State
+{
+	Mixer_SourceState sources[MIXER_SOURCE_TOTAL];
+	Mixer_StepState psg_steps;
+	cc_u32l output_sample_rate;
+	cc_u32l rate_adjustment;
+	cc_bool pal_mode;
+} Mixer_State;
+
+typedef struct Mixer
+{
+	const Mixer_Configuration *configuration;
+	const Mixer_Constant *constant;
+	Mixer_State *state;
+} Mixer;
+
+typedef void (*Mixer_OutputCallback)(void *user_data, const cc_s16l *frames, size_t total_frames);
+
+void Mixer_Constant_Initialise(Mixer_Constant *constant);
+void Mixer_State_Initialise(Mixer_State *state, cc_u32f output_sample_rate, cc_bool pal_mode);
+void Mixer_Parameters_Initialise(Mixer *mixer, const Mixer_Configuration *configuration, const Mixer_Constant *constant, Mixer_State *state);
+
+/* Speeds up or slows down the output by a 16.16 fixed-point factor, for keeping the audio in sync with the video.
+   0x10000 is the normal speed. This is clamped to between 0x8000 and 0x20000. */
+void Mixer_SetRateAdjustment(const Mixer *mixer, cc_u32f adjustment);
+
+/* Returns a zeroed buffer for the given number of frames, to be passed to the emulator's audio generation functions.
+   The PSG's frames are mono, while the other sources' frames are stereo. */
+cc_s16l* Mixer_AllocateFrames(const Mixer *mixer, Mixer_Source source, size_t total_frames);
+/* Resamples and mixes as much of the allocated audio as possible, and passes it to 'callback' as interleaved stereo
+   signed 16-bit PCM at the output sample rate. Sources which were not given any audio since the last call are silent. */
+void Mixer_Output(const Mixer *mixer, Mixer_OutputCallback callback, const void *user_data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MIXER_H */
@@ -6,6 +6,14 @@
 /* RF5C68A manual */
 /* https://segaretro.org/images/2/22/RF5C68A.pdf */
 
+typedef struct PCM_AudibleChannel
+{
+	PCM_ChannelState *state;
+	cc_u16f gains[2]; /* Volume multiplied by panning. */
+	cc_bool mixed;
+	cc_s16l *stem;
+} PCM_AudibleChannel;
+
 void PCM_State_Initialise(PCM_State* const state)
 {
 	cc_u8f i;
@@ -194,21 +202,16 @@ static cc_u8f PCM_FetchSample(const PCM* const pcm, const PCM_ChannelState* cons
 
 static cc_u8f PCM_UpdateAddressAndFetchSample(const PCM* const pcm, PCM_ChannelState* const channel)
 {
-	cc_u8f wave_value = 0;
+	/* Read sample and advance address. */
+	cc_u8f wave_value = PCM_FetchSample(pcm, channel);
+	channel->address += channel->frequency;
+	channel->address &= 0x7FFFFFF;
 
-	if (PCM_IsChannelAudible(pcm, channel))
+	/* Handle looping. */
+	if (wave_value == 0xFF)
 	{
-		/* Read sample and advance address. */
+		channel->address = channel->loop_address << 11;
 		wave_value = PCM_FetchSample(pcm, channel);
-		channel->address += channel->frequency;
-		channel->address &= 0x7FFFFFF;
-
-		/* Handle looping. */
-		if (wave_value == 0xFF)
-		{
-			channel->address = channel->loop_address << 11;
-			wave_value = PCM_FetchSample(pcm, channel);
-		}
 	}
 
 	return wave_value;
@@ -231,51 +234,79 @@ static cc_s16f PCM_UnsignedToSigned(const cc_u16f sample)
 
 void PCM_Update(const PCM* const pcm, cc_s16l* const sample_buffer, const size_t total_frames)
 {
+	PCM_AudibleChannel audible_channels[CC_COUNT_OF(pcm->state->channels)];
+	cc_u8f total_audible_channels = 0;
 	cc_s16l *sample_pointer = sample_buffer;
 	size_t current_frame;
+	cc_u8f current_channel;
+
+	/* Which channels are audible cannot change during this function, so gather them ahead of time,
+	   rather than checking every channel for every frame. */
+	for (current_channel = 0; current_channel < CC_COUNT_OF(pcm->state->channels); ++current_channel)
+	{
+		PCM_ChannelState* const channel = &pcm->state->channels[current_channel];
+		cc_s16l* const stem = pcm->configuration->channel_stems[current_channel];
+
+		/* Only the channels which are mixed write to their stems, so silence the rest. */
+		if (stem != NULL)
+		{
+			size_t i;
+
+			for (i = 0; i < total_frames * 2; ++i)
+				stem[i] = 0;
+		}
+
+		if (PCM_IsChannelAudible(pcm, channel))
+		{
+			PCM_AudibleChannel* const audible_channel = &audible_channels[total_audible_channels++];
+			cc_u8f current_mixed_sample;
+
+			audible_channel->state = channel;
+
+			/* Channels which are disabled by the frontend must still advance, but are not mixed. */
+			for (current_mixed_sample = 0; current_mixed_sample < CC_COUNT_OF(audible_channel->gains); ++current_mixed_sample)
+				audible_channel->gains[current_mixed_sample] = pcm->configuration->channels_disabled[current_channel] ? 0 : (cc_u16f)channel->volume * channel->panning[current_mixed_sample];
+
+			audible_channel->mixed = audible_channel->gains[0] != 0 || audible_channel->gains[1] != 0;
+			audible_channel->stem = stem;
+		}
+	}
+
+	/* Silence is output as 0, and the samples are added to the buffer, so there is nothing more to do. */
+	if (total_audible_channels == 0)
+		return;
 
 	for (current_frame = 0; current_frame < total_frames; ++current_frame)
 	{
 		cc_u16f mixed_samples[2] = {0x8000, 0x8000};
-		cc_u8f current_channel;
 		cc_u8f current_mixed_sample;
 
-		for (current_channel = 0; current_channel < CC_COUNT_OF(pcm->state->channels); ++current_channel)
+		for (current_channel = 0; current_channel < total_audible_channels; ++current_channel)
 		{
-			PCM_ChannelState* const channel = &pcm->state->channels[current_channel];
+			const PCM_AudibleChannel* const audible_channel = &audible_channels[current_channel];
 
-			const cc_u8f sample = PCM_UpdateAddressAndFetchSample(pcm, channel);
+			const cc_u8f sample = PCM_UpdateAddressAndFetchSample(pcm, audible_channel->state);
 
-			if (PCM_IsChannelAudible(pcm, channel) && !pcm->configuration->channels_disabled[current_channel])
+			if (audible_channel->mixed)
 			{
+				/* Mask out direction bit. */
+				const cc_u8f absolute_sample = sample & 0x7F;
+				const cc_bool add_bit = (sample & 0x80) != 0;
+
 				for (current_mixed_sample = 0; current_mixed_sample < CC_COUNT_OF(mixed_samples); ++current_mixed_sample)
 				{
-					/* Mask out direction bit and apply volume and panning. */
-					const cc_u8f absolute_sample = sample & 0x7F;
-					const cc_bool add_bit = (sample & 0x80) != 0;
-					const cc_u32f scaled_absolute_sample = ((cc_u32f)absolute_sample * channel->volume * channel->panning[current_mixed_sample]) >> 5;
+					/* Apply volume and panning. */
+					const cc_u32f scaled_absolute_sample = ((cc_u32f)absolute_sample * audible_channel->gains[current_mixed_sample]) >> 5;
+					const cc_u32f mixed_sample = mixed_samples[current_mixed_sample];
 
-					cc_u32f mixed_sample = mixed_samples[current_mixed_sample];
+					if (audible_channel->stem != NULL)
+						audible_channel->stem[current_frame * 2 + current_mixed_sample] = add_bit ? (cc_s16f)scaled_absolute_sample : -(cc_s16f)scaled_absolute_sample;
 
 					/* TODO: Check if this is how real hardware handles clipping, or if it's only done after mixing. */
 					if (add_bit)
-					{
-						mixed_sample += scaled_absolute_sample;
-
-						/* Handle overflow. */
-						if (mixed_sample > 0xFFFF)
-							mixed_sample = 0xFFFF;
-					}
+						mixed_samples[current_mixed_sample] = CC_MIN(0xFFFF, mixed_sample + scaled_absolute_sample); /* Handle overflow. */
 					else
-					{
-						mixed_sample -= scaled_absolute_sample;
-
-						/* Handle underflow. */
-						if (mixed_sample > 0xFFFF)
-							mixed_sample = 0x0000;
-					}
-
-					mixed_samples[current_mixed_sample] = mixed_sample;
+						mixed_samples[current_mixed_sample] = mixed_sample - CC_MIN(mixed_sample, scaled_absolute_sample); /* Handle underflow. */
 				}
 			}
 		}
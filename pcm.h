@@ -12,6 +12,10 @@ extern "C" {
 typedef struct PCM_Configuration
 {
 	cc_bool channels_disabled[8];
+	/* Optional buffers which 'PCM_Update' writes each channel's output to, for ripping individual channels.
+	   They are in the same format as the mix, and must be at least as large. Disabled channels are written
+	   as silence. Unlike the mix, they are not clipped. Leave these NULL to not use them. */
+	cc_s16l *channel_stems[8];
 } PCM_Configuration;
 
 typedef struct PCM_ChannelState
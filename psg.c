@@ -126,98 +126,142 @@ void PSG_DoCommand(const PSG* const psg, const cc_u8f command)
 	}
 }
 
+static void AddToSamples(cc_s16l* const sample_buffer, const size_t total_frames, const cc_s16f sample)
+{
+	size_t i;
+
+	/* Silent channels are common, so skip them entirely. */
+	if (sample == 0)
+		return;
+
+	for (i = 0; i < total_frames; ++i)
+		sample_buffer[i] += sample;
+}
+
+static void SetStem(cc_s16l* const stem, const size_t starting_frame, const size_t total_frames, const cc_s16f sample)
+{
+	size_t i;
+
+	if (stem == NULL)
+		return;
+
+	for (i = starting_frame; i < starting_frame + total_frames; ++i)
+		stem[i] = sample;
+}
+
 void PSG_Update(const PSG* const psg, cc_s16l* const sample_buffer, const size_t total_frames)
 {
 	size_t i;
 	size_t j;
-	cc_s16l *sample_buffer_pointer;
+
+	/* Rather than being processed one sample at a time, the channels are processed in runs of samples
+	   between each phase change, during which their output is constant. */
 
 	/* Do the tone channels. */
 	for (i = 0; i < CC_COUNT_OF(psg->state->tones); ++i)
 	{
-		if (!psg->configuration->tone_disabled[i])
+		cc_s16l* const stem = psg->configuration->channel_stems[i];
+
+		if (psg->configuration->tone_disabled[i])
+		{
+			SetStem(stem, 0, total_frames, 0);
+		}
+		else
 		{
 			PSG_ToneState* const tone = &psg->state->tones[i];
 
-			sample_buffer_pointer = sample_buffer;
-
-			for (j = 0; j < total_frames; ++j)
+			for (j = 0; j < total_frames; )
 			{
-				/* This countdown is responsible for the channel's frequency. */
-				if (tone->countdown != 0)
-					--tone->countdown;
-
-				/* Curiously, the phase never changes if the frequency is at its maximum.
+				/* This countdown is responsible for the channel's frequency.
+				   Curiously, the phase never changes if the frequency is at its maximum.
 				   This can be exploited to play PCM samples. After Burner II relies on this. */
-				if (tone->countdown_master != 0 && tone->countdown == 0)
+				const size_t samples_until_change = tone->countdown_master == 0 ? total_frames - j : CC_MIN(total_frames - j, tone->countdown == 0 ? 0 : tone->countdown - 1u);
+
+				AddToSamples(&sample_buffer[j], samples_until_change, psg->constant->volumes[tone->attenuation][tone->output_bit]);
+				SetStem(stem, j, samples_until_change, psg->constant->volumes[tone->attenuation][tone->output_bit]);
+				tone->countdown -= CC_MIN(tone->countdown, samples_until_change);
+				j += samples_until_change;
+
+				if (j != total_frames)
 				{
 					/* Reset the countdown. */
 					tone->countdown = tone->countdown_master;
 
 					/* Switch from positive phase to negative phase and vice versa. */
 					tone->output_bit = !tone->output_bit;
-				}
 
-				/* Output a sample. */
-				*sample_buffer_pointer++ += psg->constant->volumes[tone->attenuation][tone->output_bit];
+					/* Output a sample. */
+					SetStem(stem, j, 1, psg->constant->volumes[tone->attenuation][tone->output_bit]);
+					sample_buffer[j++] += psg->constant->volumes[tone->attenuation][tone->output_bit];
+				}
 			}
 		}
 	}
 
-	if (!psg->configuration->noise_disabled)
+	if (psg->configuration->noise_disabled)
+	{
+		SetStem(psg->configuration->channel_stems[3], 0, total_frames, 0);
+	}
+	else
 	{
 		/* Do the noise channel. */
-		sample_buffer_pointer = sample_buffer;
+		PSG_NoiseState* const noise = &psg->state->noise;
+		cc_s16l* const stem = psg->configuration->channel_stems[3];
 
-		for (j = 0; j < total_frames; ++j)
+		for (j = 0; j < total_frames; )
 		{
 			/* This countdown is responsible for the channel's frequency. */
-			if (psg->state->noise.countdown != 0)
-				--psg->state->noise.countdown;
+			const size_t samples_until_change = CC_MIN(total_frames - j, noise->countdown == 0 ? 0 : noise->countdown - 1u);
+
+			AddToSamples(&sample_buffer[j], samples_until_change, psg->constant->volumes[noise->attenuation][noise->real_output_bit]);
+			SetStem(stem, j, samples_until_change, psg->constant->volumes[noise->attenuation][noise->real_output_bit]);
+			noise->countdown -= samples_until_change;
+			j += samples_until_change;
 
-			if (psg->state->noise.countdown == 0)
+			if (j != total_frames)
 			{
 				/* Reset the countdown. */
-				switch (psg->state->noise.frequency_mode)
+				switch (noise->frequency_mode)
 				{
 					case 0:
-						psg->state->noise.countdown = 0x10;
+						noise->countdown = 0x10;
 						break;
 
 					case 1:
-						psg->state->noise.countdown = 0x20;
+						noise->countdown = 0x20;
 						break;
 
 					case 2:
-						psg->state->noise.countdown = 0x40;
+						noise->countdown = 0x40;
 						break;
 
 					case 3:
 						/* Use the last tone channel's frequency. */
-						psg->state->noise.countdown = psg->state->tones[CC_COUNT_OF(psg->state->tones) - 1].countdown_master;
+						noise->countdown = psg->state->tones[CC_COUNT_OF(psg->state->tones) - 1].countdown_master;
 						break;
 				}
 
-				psg->state->noise.fake_output_bit = !psg->state->noise.fake_output_bit;
+				noise->fake_output_bit = !noise->fake_output_bit;
 
-				if (psg->state->noise.fake_output_bit)
+				if (noise->fake_output_bit)
 				{
 					/* The noise channel works by maintaining a 16-bit register, whose bits are rotated every time
 					   the output bit goes from low to high. The bit that was rotated from the 'bottom' of the
 					   register to the 'top' is what is output to the speaker. In white noise mode, after rotation,
 					   the bit at the 'top' is XOR'd with the bit that is third from the 'bottom'. */
-					psg->state->noise.real_output_bit = (psg->state->noise.shift_register & 0x8000) >> 15;
+					noise->real_output_bit = (noise->shift_register & 0x8000) >> 15;
 
-					psg->state->noise.shift_register <<= 1;
-					psg->state->noise.shift_register |= psg->state->noise.real_output_bit;
+					noise->shift_register <<= 1;
+					noise->shift_register |= noise->real_output_bit;
 
-					if (psg->state->noise.type == PSG_NOISE_TYPE_WHITE)
-						psg->state->noise.shift_register ^= (psg->state->noise.shift_register & 0x2000) >> 13;
+					if (noise->type == PSG_NOISE_TYPE_WHITE)
+						noise->shift_register ^= (noise->shift_register & 0x2000) >> 13;
 				}
-			}
 
-			/* Output a sample. */
-			*sample_buffer_pointer++ += psg->constant->volumes[psg->state->noise.attenuation][psg->state->noise.real_output_bit];
+				/* Output a sample. */
+				SetStem(stem, j, 1, psg->constant->volumes[noise->attenuation][noise->real_output_bit]);
+				sample_buffer[j++] += psg->constant->volumes[noise->attenuation][noise->real_output_bit];
+			}
 		}
 	}
 }
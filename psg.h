@@ -65,6 +65,11 @@ typedef struct PSG_Configuration
 {
 	cc_bool tone_disabled[3];
 	cc_bool noise_disabled;
+	/* Optional buffers which 'PSG_Update' writes each channel's output to, for ripping individual channels.
+	   The first three are the tone channels, and the last is the noise channel. They are in the same format
+	   as the mix, and must be at least as large. Disabled channels are written as silence.
+	   Leave these NULL to not use them. */
+	cc_s16l *channel_stems[4];
 } PSG_Configuration;
 
 typedef struct PSG_Constant
@@ -3,6 +3,7 @@
 #include "bus-main-m68k.c"
 #include "bus-sub-m68k.c"
 #include "bus-z80.c"
+#include "cdda-stream.c"
 #include "clownmdemu.c"
 #include "controller.c"
 #include "fm.c"
@@ -11,7 +12,9 @@
 #include "fm-phase.c"
 #include "io-port.c"
 #include "log.c"
+#include "mixer.c"
 #include "pcm.c"
 #include "psg.c"
 #include "vdp.c"
+#include "vgm.c"
 #include "z80.c"
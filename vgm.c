@@ -0,0 +1,293 @@
+#include "vgm.h"
+
+#include <string.h>
+
+#include "clowncommon/clowncommon.h"
+
+#include "clownmdemu.h"
+
+/* VGM file format specification */
+/* https://vgmrips.net/wiki/VGM_Specification */
+
+#define VGM_SAMPLE_RATE 44100
+
+#define VGM_COMMAND_PSG_WRITE 0x50
+#define VGM_COMMAND_FM_PORT_0_WRITE 0x52
+#define VGM_COMMAND_FM_PORT_1_WRITE 0x53
+#define VGM_COMMAND_WAIT 0x61
+#define VGM_COMMAND_WAIT_NTSC_FRAME 0x62
+#define VGM_COMMAND_WAIT_PAL_FRAME 0x63
+#define VGM_COMMAND_END_OF_SOUND_DATA 0x66
+#define VGM_COMMAND_DATA_BLOCK 0x67
+#define VGM_COMMAND_SHORT_WAIT 0x70
+#define VGM_COMMAND_DAC_WRITE_AND_WAIT 0x80
+#define VGM_COMMAND_DAC_SEEK 0xE0
+
+static cc_u32f GetMasterClock(const VGM_State* const state)
+{
+	return state->pal_mode ? CLOWNMDEMU_MASTER_CLOCK_PAL : CLOWNMDEMU_MASTER_CLOCK_NTSC;
+}
+
+static cc_u32f GetCyclesPerFrame(const VGM_State* const state)
+{
+	return state->pal_mode ? CLOWNMDEMU_DIVIDE_BY_PAL_FRAMERATE(CLOWNMDEMU_MASTER_CLOCK_PAL) : CLOWNMDEMU_DIVIDE_BY_NTSC_FRAMERATE(CLOWNMDEMU_MASTER_CLOCK_NTSC);
+}
+
+static cc_u32f CyclesToSamples(const VGM_State* const state, const cc_u32f cycles, cc_u32f* const remainder)
+{
+	/* This is 'cycles * VGM_SAMPLE_RATE / master_clock', done with long division to avoid overflowing 32 bits.
+	   The sample rate is split into factors which are small enough for this to work. */
+	static const cc_u8l sample_rate_factors[] = {21, 21, 10, 10};
+
+	const cc_u32f master_clock = GetMasterClock(state);
+
+	cc_u32f quotient, i;
+
+	quotient = cycles / master_clock;
+	*remainder = cycles % master_clock;
+
+	for (i = 0; i < CC_COUNT_OF(sample_rate_factors); ++i)
+	{
+		quotient = quotient * sample_rate_factors[i] + *remainder * sample_rate_factors[i] / master_clock;
+		*remainder = *remainder * sample_rate_factors[i] % master_clock;
+	}
+
+	/* Continue from where the frame began. */
+	*remainder += state->frame_start_remainder;
+	quotient += state->frame_start_sample + *remainder / master_clock;
+	*remainder %= master_clock;
+
+	return quotient;
+}
+
+static void FlushOutputBuffer(const VGM* const vgm)
+{
+	VGM_State* const state = vgm->state;
+
+	if (state->output_buffer_length != 0)
+		vgm->output_callback((void*)vgm->user_data, state->output_buffer, state->output_buffer_length);
+
+	state->output_buffer_length = 0;
+}
+
+static void OutputByte(const VGM* const vgm, const cc_u8f byte)
+{
+	VGM_State* const state = vgm->state;
+
+	if (state->output_buffer_length == CC_COUNT_OF(state->output_buffer))
+		FlushOutputBuffer(vgm);
+
+	state->output_buffer[state->output_buffer_length++] = byte;
+	++state->total_bytes;
+}
+
+static void OutputLongWord(const VGM* const vgm, const cc_u32f long_word)
+{
+	OutputByte(vgm, (long_word >> 8 * 0) & 0xFF);
+	OutputByte(vgm, (long_word >> 8 * 1) & 0xFF);
+	OutputByte(vgm, (long_word >> 8 * 2) & 0xFF);
+	OutputByte(vgm, (long_word >> 8 * 3) & 0xFF);
+}
+
+static void WriteLongWord(cc_u8l* const buffer, const cc_u32f long_word)
+{
+	buffer[0] = (long_word >> 8 * 0) & 0xFF;
+	buffer[1] = (long_word >> 8 * 1) & 0xFF;
+	buffer[2] = (long_word >> 8 * 2) & 0xFF;
+	buffer[3] = (long_word >> 8 * 3) & 0xFF;
+}
+
+static void WaitUntil(const VGM* const vgm, const cc_u32f sample)
+{
+	VGM_State* const state = vgm->state;
+
+	while (state->samples_waited != sample)
+	{
+		const cc_u32f samples = CC_MIN(0xFFFF, sample - state->samples_waited);
+
+		if (samples <= 0x10)
+		{
+			OutputByte(vgm, VGM_COMMAND_SHORT_WAIT | (samples - 1));
+		}
+		else if (samples == VGM_SAMPLE_RATE / 60)
+		{
+			OutputByte(vgm, VGM_COMMAND_WAIT_NTSC_FRAME);
+		}
+		else if (samples == VGM_SAMPLE_RATE / 50)
+		{
+			OutputByte(vgm, VGM_COMMAND_WAIT_PAL_FRAME);
+		}
+		else
+		{
+			OutputByte(vgm, VGM_COMMAND_WAIT);
+			OutputByte(vgm, (samples >> 8 * 0) & 0xFF);
+			OutputByte(vgm, (samples >> 8 * 1) & 0xFF);
+		}
+
+		state->samples_waited += samples;
+	}
+}
+
+static cc_bool IsDACWrite(const VGM_Event* const event)
+{
+	return event->command == VGM_COMMAND_FM_PORT_0_WRITE && event->address == 0x2A;
+}
+
+static void FlushEvents(const VGM* const vgm)
+{
+	VGM_State* const state = vgm->state;
+
+	cc_u32f total_dac_writes, i;
+
+	/* Rather than being written individually, the DAC's samples are gathered into a data block, which is then
+	   streamed from. This reduces each sample to a single byte, which also contains the wait that follows it. */
+	total_dac_writes = 0;
+
+	for (i = 0; i < state->total_events; ++i)
+		if (IsDACWrite(&state->events[i]))
+			++total_dac_writes;
+
+	if (total_dac_writes != 0)
+	{
+		OutputByte(vgm, VGM_COMMAND_DATA_BLOCK);
+		OutputByte(vgm, VGM_COMMAND_END_OF_SOUND_DATA); /* For compatibility with older players. */
+		OutputByte(vgm, 0x00); /* YM2612 PCM data. */
+		OutputLongWord(vgm, total_dac_writes);
+
+		for (i = 0; i < state->total_events; ++i)
+			if (IsDACWrite(&state->events[i]))
+				OutputByte(vgm, state->events[i].data);
+
+		/* Every data block is appended to the same bank, so skip the previous ones. */
+		OutputByte(vgm, VGM_COMMAND_DAC_SEEK);
+		OutputLongWord(vgm, state->dac_bank_size);
+
+		state->dac_bank_size += total_dac_writes;
+	}
+
+	for (i = 0; i < state->total_events; ++i)
+	{
+		const VGM_Event* const event = &state->events[i];
+
+		WaitUntil(vgm, event->sample);
+
+		if (IsDACWrite(event))
+		{
+			const cc_u32f next_sample = i + 1 != state->total_events ? state->events[i + 1].sample : event->sample;
+			const cc_u32f samples = CC_MIN(0xF, next_sample - event->sample);
+
+			OutputByte(vgm, VGM_COMMAND_DAC_WRITE_AND_WAIT | samples);
+			state->samples_waited += samples;
+		}
+		else
+		{
+			OutputByte(vgm, event->command);
+
+			if (event->command != VGM_COMMAND_PSG_WRITE)
+				OutputByte(vgm, event->address);
+
+			OutputByte(vgm, event->data);
+		}
+	}
+
+	state->total_events = 0;
+}
+
+void VGM_Parameters_Initialise(VGM* const vgm, VGM_State* const state, const VGM_OutputCallback output_callback, const void* const user_data)
+{
+	vgm->state = state;
+	vgm->output_callback = output_callback;
+	vgm->user_data = user_data;
+}
+
+void VGM_Begin(const VGM* const vgm, const cc_bool pal_mode)
+{
+	VGM_State* const state = vgm->state;
+
+	cc_u8l header[VGM_HEADER_SIZE];
+	cc_u16f i;
+
+	state->total_events = 0;
+	state->output_buffer_length = 0;
+	state->total_bytes = 0;
+	state->samples_waited = 0;
+	state->frame_start_sample = 0;
+	state->frame_start_remainder = 0;
+	state->dac_bank_size = 0;
+	state->pal_mode = pal_mode;
+
+	/* The lengths in this are not known yet, so it will have to be written again by the frontend afterwards. */
+	VGM_GetHeader(vgm, header);
+
+	for (i = 0; i < CC_COUNT_OF(header); ++i)
+		OutputByte(vgm, header[i]);
+}
+
+void VGM_LogWrite(const VGM* const vgm, const ClownMDEmu_SoundChip chip, const cc_u8f port, const cc_u8f address, const cc_u8f data, const cc_u32f cycle)
+{
+	VGM_State* const state = vgm->state;
+
+	cc_u32f remainder, sample, i;
+
+	if (state->total_events == CC_COUNT_OF(state->events))
+		FlushEvents(vgm);
+
+	/* The FM and PSG are written by different CPUs, which do not run in lockstep, so their writes can arrive
+	   slightly out of order. Keep them sorted, but they cannot be moved before what has already been output. */
+	sample = CC_MAX(state->samples_waited, CyclesToSamples(state, cycle, &remainder));
+
+	for (i = state->total_events; i != 0 && state->events[i - 1].sample > sample; --i)
+		state->events[i] = state->events[i - 1];
+
+	state->events[i].sample = sample;
+	state->events[i].command = chip == CLOWNMDEMU_SOUND_CHIP_PSG ? VGM_COMMAND_PSG_WRITE : port == 0 ? VGM_COMMAND_FM_PORT_0_WRITE : VGM_COMMAND_FM_PORT_1_WRITE;
+	state->events[i].address = address;
+	state->events[i].data = data;
+	++state->total_events;
+}
+
+void VGM_EndFrame(const VGM* const vgm)
+{
+	VGM_State* const state = vgm->state;
+
+	cc_u32f remainder;
+
+	state->frame_start_sample = CyclesToSamples(state, GetCyclesPerFrame(state), &remainder);
+	state->frame_start_remainder = remainder;
+}
+
+void VGM_End(const VGM* const vgm)
+{
+	FlushEvents(vgm);
+
+	/* Include the silence at the end, so that the file's duration matches the recording. */
+	WaitUntil(vgm, CC_MAX(vgm->state->samples_waited, vgm->state->frame_start_sample));
+	OutputByte(vgm, VGM_COMMAND_END_OF_SOUND_DATA);
+
+	FlushOutputBuffer(vgm);
+}
+
+void VGM_GetHeader(const VGM* const vgm, cc_u8l* const header)
+{
+	const VGM_State* const state = vgm->state;
+	const cc_u32f master_clock = GetMasterClock(state);
+
+	memset(header, 0, VGM_HEADER_SIZE);
+
+	header[0x00] = 'V';
+	header[0x01] = 'g';
+	header[0x02] = 'm';
+	header[0x03] = ' ';
+	/* Offsets are relative to their own position in the header. */
+	WriteLongWord(&header[0x04], state->total_bytes - 0x04);
+	WriteLongWord(&header[0x08], 0x171); /* Version number. */
+	WriteLongWord(&header[0x0C], master_clock / CLOWNMDEMU_Z80_CLOCK_DIVIDER); /* SN76489 clock. */
+	WriteLongWord(&header[0x18], state->samples_waited);
+	WriteLongWord(&header[0x24], state->pal_mode ? 50 : 60);
+	/* SN76489 feedback pattern and shift register width, as used by the Mega Drive. */
+	header[0x28] = 0x09;
+	header[0x29] = 0x00;
+	header[0x2A] = 16;
+	WriteLongWord(&header[0x2C], master_clock / CLOWNMDEMU_M68K_CLOCK_DIVIDER); /* YM2612 clock. */
+	WriteLongWord(&header[0x34], VGM_HEADER_SIZE - 0x34);
+}
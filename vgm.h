@@ -0,0 +1,67 @@
+#ifndef VGM_H
+#define VGM_H
+
+#include <stddef.h>
+
+#include "clowncommon/clowncommon.h"
+
+#include "clownmdemu.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define VGM_HEADER_SIZE 0x100
+/* How many writes are held back before being output. DAC writes are gathered from these into data blocks. */
+#define VGM_MAXIMUM_EVENTS 0x800
+#define VGM_OUTPUT_BUFFER_SIZE 0x1000
+
+typedef struct VGM_Event
+{
+	cc_u32l sample;
+	cc_u8l command;
+	cc_u8l address;
+	cc_u8l data;
+} VGM_Event;
+
+typedef struct VGM_State
+{
+	VGM_Event events[VGM_MAXIMUM_EVENTS]; /* Sorted by time. */
+	cc_u16l total_events;
+	cc_u8l output_buffer[VGM_OUTPUT_BUFFER_SIZE];
+	cc_u16l output_buffer_length;
+	cc_u32l total_bytes; /* Including the header. */
+	cc_u32l samples_waited;
+	/* The current frame begins at sample 'frame_start_sample + frame_start_remainder / master_clock'. */
+	cc_u32l frame_start_sample;
+	cc_u32l frame_start_remainder;
+	cc_u32l dac_bank_size;
+	cc_bool pal_mode;
+} VGM_State;
+
+typedef void (*VGM_OutputCallback)(void *user_data, const cc_u8l *bytes, size_t total_bytes);
+
+typedef struct VGM
+{
+	VGM_State *state;
+	VGM_OutputCallback output_callback;
+	const void *user_data;
+} VGM;
+
+/* An optional component for frontends, which records the FM and PSG's music to a VGM 1.71 file, as it plays.
+   The emulator's 'sound_chip_written' callback should be forwarded to 'VGM_LogWrite', and 'VGM_EndFrame' should be
+   called after every 'ClownMDEmu_Iterate'. The file is output through 'output_callback' in chunks. As the file's
+   length is not known until it ends, the header should be overwritten with 'VGM_GetHeader' afterwards.
+   The chips' existing state is not recorded, so logging should begin when the emulator is reset. */
+void VGM_Parameters_Initialise(VGM *vgm, VGM_State *state, VGM_OutputCallback output_callback, const void *user_data);
+void VGM_Begin(const VGM *vgm, cc_bool pal_mode);
+void VGM_LogWrite(const VGM *vgm, ClownMDEmu_SoundChip chip, cc_u8f port, cc_u8f address, cc_u8f data, cc_u32f cycle);
+void VGM_EndFrame(const VGM *vgm);
+void VGM_End(const VGM *vgm);
+void VGM_GetHeader(const VGM *vgm, cc_u8l *header);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VGM_H */
@@ -37,6 +37,34 @@ enum
 	FLAG_MASK_SIGN = 1 << FLAG_BIT_SIGN
 };
 
+/* How to calculate the flags that were left out of date by an ALU instruction. */
+enum
+{
+	FLAGS_OPERATION_NONE, /* 'f' is up to date. */
+	FLAGS_OPERATION_ADD,
+	FLAGS_OPERATION_SUBTRACT,
+	FLAGS_OPERATION_AND,
+	FLAGS_OPERATION_OR /* Also used by XOR, which sets the flags the same way. */
+};
+
+/* Register pairs are stored as 16-bit values, so these are used to access their 8-bit halves. */
+#define HIGH_BYTE(pair) (((pair) >> 8) & 0xFF)
+#define LOW_BYTE(pair) ((pair) & 0xFF)
+#define SET_HIGH_BYTE(pair, value) (pair) = ((pair) & 0xFF) | (((cc_u16f)(value) & 0xFF) << 8)
+#define SET_LOW_BYTE(pair, value) (pair) = ((pair) & 0xFF00) | ((cc_u16f)(value) & 0xFF)
+
+/* The most common instructions have variants with their operands baked-in, to avoid the overhead of `ReadOperand` and `WriteOperand`. */
+/* Specialised operands are indexed as follows: 0-6 are the registers A, B, C, D, E, H, and L, 7 is any 8-bit memory operand, and 8 is an 8-bit literal. */
+enum
+{
+	HANDLER_SPECIALISED_OPERANDS = 9,
+	HANDLER_LD_8BIT_FIRST = Z80_OPCODE_OTDR + 1, /* Destination * HANDLER_SPECIALISED_OPERANDS + source. */
+	HANDLER_ALU_FIRST = HANDLER_LD_8BIT_FIRST + 8 * HANDLER_SPECIALISED_OPERANDS, /* Operation * HANDLER_SPECIALISED_OPERANDS + source. */
+	HANDLER_INC_8BIT_FIRST = HANDLER_ALU_FIRST + 8 * HANDLER_SPECIALISED_OPERANDS, /* Register. */
+	HANDLER_DEC_8BIT_FIRST = HANDLER_INC_8BIT_FIRST + 7, /* Register. */
+	HANDLER_END = HANDLER_DEC_8BIT_FIRST + 7 /* This must not exceed 0x100, as handlers are stored in a 'cc_u8l'. */
+};
+
 typedef struct Z80Instruction
 {
 #ifdef Z80_PRECOMPUTE_INSTRUCTION_METADATA
@@ -84,6 +112,52 @@ static cc_bool EvaluateCondition(const cc_u8l flags, const Z80_Condition conditi
 	}
 }
 
+static cc_u8f GetParityFlag(const cc_u16f value)
+{
+	/* http://graphics.stanford.edu/~seander/bithacks.html#ParityMultiply */
+	/* I have absolutely no idea how this works. */
+	cc_u16f v;
+
+	v = value;
+	v ^= v >> 1;
+	v ^= v >> 2;
+	v = (v & 0x11) * 0x11;
+
+	return (v & 0x10) == 0 ? FLAG_MASK_PARITY_OVERFLOW : 0;
+}
+
+static cc_u8f GetDeferredSignZeroCarryFlags(const Z80_State* const state)
+{
+	/* These are set the same way by every deferred operation. */
+	const cc_u16f result_value = state->flags_result & 0xFF;
+
+	cc_u8f flags = 0;
+	flags |= (result_value >> (7 - FLAG_BIT_SIGN)) & FLAG_MASK_SIGN;
+	flags |= result_value == 0 ? FLAG_MASK_ZERO : 0;
+	flags |= (state->flags_result >> (8 - FLAG_BIT_CARRY)) & FLAG_MASK_CARRY;
+	return flags;
+}
+
+static void MaterialiseFlags(const Z80* const z80)
+{
+	z80->state->f = Z80_GetFlags(z80->state);
+	z80->state->flags_operation = FLAGS_OPERATION_NONE;
+}
+
+static cc_bool EvaluateConditionDeferred(const Z80* const z80, const Z80_Condition condition)
+{
+	if (z80->state->flags_operation != FLAGS_OPERATION_NONE)
+	{
+		/* Most conditions can be evaluated without calculating all of the flags. */
+		if (condition != Z80_CONDITION_PARITY_OVERFLOW && condition != Z80_CONDITION_PARITY_EQUALITY)
+			return EvaluateCondition(GetDeferredSignZeroCarryFlags(z80->state), condition);
+
+		MaterialiseFlags(z80);
+	}
+
+	return EvaluateCondition(z80->state->f, condition);
+}
+
 static cc_u16f MemoryRead(const Z80* const z80, const Z80_ReadAndWriteCallbacks* const callbacks, const cc_u16f address)
 {
 	/* Memory accesses take 3 cycles. */
@@ -102,7 +176,19 @@ static void MemoryWrite(const Z80* const z80, const Z80_ReadAndWriteCallbacks* c
 
 static cc_u16f InstructionMemoryRead(const Z80* const z80, const Z80_ReadAndWriteCallbacks* const callbacks)
 {
-	const cc_u16f data = MemoryRead(z80, callbacks, z80->state->program_counter);
+	cc_u16f data;
+
+	if (z80->state->program_counter < callbacks->memory_size)
+	{
+		/* Bypass the callback. Memory accesses still take 3 cycles though. */
+		z80->state->cycles += 3;
+
+		data = callbacks->memory[z80->state->program_counter];
+	}
+	else
+	{
+		data = MemoryRead(z80, callbacks, z80->state->program_counter);
+	}
 
 	++z80->state->program_counter;
 	z80->state->program_counter &= 0xFFFF;
@@ -110,13 +196,18 @@ static cc_u16f InstructionMemoryRead(const Z80* const z80, const Z80_ReadAndWrit
 	return data;
 }
 
+static void IncrementRRegister(const Z80* const z80, const cc_u32f amount)
+{
+	/* Only the lower 7 bits of the 'R' register are incremented. */
+	z80->state->r = (z80->state->r & 0x80) | ((z80->state->r + amount) & 0x7F);
+}
+
 static cc_u16f OpcodeFetch(const Z80* const z80, const Z80_ReadAndWriteCallbacks* const callbacks)
 {
 	/* Opcode fetches take an extra cycle. */
 	++z80->state->cycles;
 
-	/* Increment the lower 7 bits of the 'R' register. */
-	z80->state->r = (z80->state->r & 0x80) | ((z80->state->r + 1) & 0x7F);
+	IncrementRRegister(z80, 1);
 
 	return InstructionMemoryRead(z80, callbacks);
 }
@@ -158,67 +249,67 @@ static cc_u16f ReadOperand(const Z80* const z80, const Z80_ReadAndWriteCallbacks
 			break;
 
 		case Z80_OPERAND_B:
-			value = z80->state->b;
+			value = HIGH_BYTE(z80->state->bc);
 			break;
 
 		case Z80_OPERAND_C:
-			value = z80->state->c;
+			value = LOW_BYTE(z80->state->bc);
 			break;
 
 		case Z80_OPERAND_D:
-			value = z80->state->d;
+			value = HIGH_BYTE(z80->state->de);
 			break;
 
 		case Z80_OPERAND_E:
-			value = z80->state->e;
+			value = LOW_BYTE(z80->state->de);
 			break;
 
 		case Z80_OPERAND_H:
-			value = z80->state->h;
+			value = HIGH_BYTE(z80->state->hl);
 			break;
 
 		case Z80_OPERAND_L:
-			value = z80->state->l;
+			value = LOW_BYTE(z80->state->hl);
 			break;
 
 		case Z80_OPERAND_IXH:
-			value = z80->state->ixh;
+			value = HIGH_BYTE(z80->state->ix);
 			break;
 
 		case Z80_OPERAND_IXL:
-			value = z80->state->ixl;
+			value = LOW_BYTE(z80->state->ix);
 			break;
 
 		case Z80_OPERAND_IYH:
-			value = z80->state->iyh;
+			value = HIGH_BYTE(z80->state->iy);
 			break;
 
 		case Z80_OPERAND_IYL:
-			value = z80->state->iyl;
+			value = LOW_BYTE(z80->state->iy);
 			break;
 
 		case Z80_OPERAND_AF:
-			value = ((cc_u16f)z80->state->a << 8) | z80->state->f;
+			value = ((cc_u16f)z80->state->a << 8) | Z80_GetFlags(z80->state);
 			break;
 
 		case Z80_OPERAND_BC:
-			value = ((cc_u16f)z80->state->b << 8) | z80->state->c;
+			value = z80->state->bc;
 			break;
 
 		case Z80_OPERAND_DE:
-			value = ((cc_u16f)z80->state->d << 8) | z80->state->e;
+			value = z80->state->de;
 			break;
 
 		case Z80_OPERAND_HL:
-			value = ((cc_u16f)z80->state->h << 8) | z80->state->l;
+			value = z80->state->hl;
 			break;
 
 		case Z80_OPERAND_IX:
-			value = ((cc_u16f)z80->state->ixh << 8) | z80->state->ixl;
+			value = z80->state->ix;
 			break;
 
 		case Z80_OPERAND_IY:
-			value = ((cc_u16f)z80->state->iyh << 8) | z80->state->iyl;
+			value = z80->state->iy;
 			break;
 
 		case Z80_OPERAND_PC:
@@ -275,73 +366,69 @@ static void WriteOperand(const Z80* const z80, const Z80_ReadAndWriteCallbacks*
 			break;
 
 		case Z80_OPERAND_B:
-			z80->state->b = value;
+			SET_HIGH_BYTE(z80->state->bc, value);
 			break;
 
 		case Z80_OPERAND_C:
-			z80->state->c = value;
+			SET_LOW_BYTE(z80->state->bc, value);
 			break;
 
 		case Z80_OPERAND_D:
-			z80->state->d = value;
+			SET_HIGH_BYTE(z80->state->de, value);
 			break;
 
 		case Z80_OPERAND_E:
-			z80->state->e = value;
+			SET_LOW_BYTE(z80->state->de, value);
 			break;
 
 		case Z80_OPERAND_H:
-			z80->state->h = value;
+			SET_HIGH_BYTE(z80->state->hl, value);
 			break;
 
 		case Z80_OPERAND_L:
-			z80->state->l = value;
+			SET_LOW_BYTE(z80->state->hl, value);
 			break;
 
 		case Z80_OPERAND_IXH:
-			z80->state->ixh = value;
+			SET_HIGH_BYTE(z80->state->ix, value);
 			break;
 
 		case Z80_OPERAND_IXL:
-			z80->state->ixl = value;
+			SET_LOW_BYTE(z80->state->ix, value);
 			break;
 
 		case Z80_OPERAND_IYH:
-			z80->state->iyh = value;
+			SET_HIGH_BYTE(z80->state->iy, value);
 			break;
 
 		case Z80_OPERAND_IYL:
-			z80->state->iyl = value;
+			SET_LOW_BYTE(z80->state->iy, value);
 			break;
 
 		case Z80_OPERAND_AF:
 			z80->state->a = value >> 8;
 			z80->state->f = value & 0xFF;
+			z80->state->flags_operation = FLAGS_OPERATION_NONE;
 			break;
 
 		case Z80_OPERAND_BC:
-			z80->state->b = value >> 8;
-			z80->state->c = value & 0xFF;
+			z80->state->bc = value;
 			break;
 
 		case Z80_OPERAND_DE:
-			z80->state->d = value >> 8;
-			z80->state->e = value & 0xFF;
+			z80->state->de = value;
 			break;
 
 		case Z80_OPERAND_HL:
-			z80->state->h = value >> 8;
-			z80->state->l = value & 0xFF;
+			z80->state->hl = value;
 			break;
 
 		case Z80_OPERAND_IX:
-			z80->state->ixh = value >> 8;
-			z80->state->ixl = value & 0xFF;
+			z80->state->ix = value;
 			break;
 
 		case Z80_OPERAND_IY:
-			z80->state->iyh = value >> 8;
-			z80->state->iyl = value & 0xFF;
+			z80->state->iy = value;
 			break;
 
 		case Z80_OPERAND_PC:
@@ -367,6 +454,81 @@ static void WriteOperand(const Z80* const z80, const Z80_ReadAndWriteCallbacks*
 	}
 }
 
+static cc_u8f GetSpecialisedOperandIndex(const Z80_Operand operand)
+{
+	switch (operand)
+	{
+		case Z80_OPERAND_A:
+		case Z80_OPERAND_B:
+		case Z80_OPERAND_C:
+		case Z80_OPERAND_D:
+		case Z80_OPERAND_E:
+		case Z80_OPERAND_H:
+		case Z80_OPERAND_L:
+			return operand - Z80_OPERAND_A;
+
+		case Z80_OPERAND_BC_INDIRECT:
+		case Z80_OPERAND_DE_INDIRECT:
+		case Z80_OPERAND_HL_INDIRECT:
+		case Z80_OPERAND_IX_INDIRECT:
+		case Z80_OPERAND_IY_INDIRECT:
+		case Z80_OPERAND_ADDRESS:
+			return 7;
+
+		case Z80_OPERAND_LITERAL_8BIT:
+			return 8;
+
+		default:
+			return HANDLER_SPECIALISED_OPERANDS;
+	}
+}
+
+static cc_u8f GetHandler(const Z80_InstructionMetadata* const metadata)
+{
+	const cc_u8f source = GetSpecialisedOperandIndex((Z80_Operand)metadata->operands[0]);
+	const cc_u8f destination = GetSpecialisedOperandIndex((Z80_Operand)metadata->operands[1]);
+
+	switch ((Z80_Opcode)metadata->opcode)
+	{
+		case Z80_OPCODE_LD_8BIT:
+			/* Literals cannot be written to, and memory-to-memory transfers do not exist. */
+			if (source < HANDLER_SPECIALISED_OPERANDS && destination < 7 + (source != 7))
+				return HANDLER_LD_8BIT_FIRST + destination * HANDLER_SPECIALISED_OPERANDS + source;
+
+			break;
+
+		case Z80_OPCODE_ADD_A:
+		case Z80_OPCODE_ADC_A:
+		case Z80_OPCODE_SUB:
+		case Z80_OPCODE_SBC_A:
+		case Z80_OPCODE_AND:
+		case Z80_OPCODE_XOR:
+		case Z80_OPCODE_OR:
+		case Z80_OPCODE_CP:
+			if (source < HANDLER_SPECIALISED_OPERANDS)
+				return HANDLER_ALU_FIRST + (metadata->opcode - Z80_OPCODE_ADD_A) * HANDLER_SPECIALISED_OPERANDS + source;
+
+			break;
+
+		case Z80_OPCODE_INC_8BIT:
+			if (destination < 7)
+				return HANDLER_INC_8BIT_FIRST + destination;
+
+			break;
+
+		case Z80_OPCODE_DEC_8BIT:
+			if (destination < 7)
+				return HANDLER_DEC_8BIT_FIRST + destination;
+
+			break;
+
+		default:
+			break;
+	}
+
+	return metadata->opcode;
+}
+
 static void DecodeInstructionMetadata(Z80_InstructionMetadata* const metadata, const InstructionMode instruction_mode, const Z80_RegisterMode register_mode, const cc_u8l opcode)
 {
 	static const Z80_Operand registers[8] = {Z80_OPERAND_B, Z80_OPERAND_C, Z80_OPERAND_D, Z80_OPERAND_E, Z80_OPERAND_H, Z80_OPERAND_L, Z80_OPERAND_HL_INDIRECT, Z80_OPERAND_A};
@@ -887,6 +1049,8 @@ static void DecodeInstructionMetadata(Z80_InstructionMetadata* const metadata, c
 			}
 		}
 	}
+
+	metadata->handler = GetHandler(metadata);
 }
 
 static void DecodeInstruction(const Z80* const z80, const Z80_ReadAndWriteCallbacks* const callbacks, Z80Instruction* const instruction)
@@ -949,9 +1113,9 @@ static void DecodeInstruction(const Z80* const z80, const Z80_ReadAndWriteCallba
 				z80->state->cycles -= 3;
 
 				if (z80->state->register_mode == Z80_REGISTER_MODE_IX)
-					instruction->address = ((((cc_u16f)z80->state->ixh << 8) | z80->state->ixl) + displacement) & 0xFFFF;
+					instruction->address = (z80->state->ix + displacement) & 0xFFFF;
 				else /*if (z80->state->register_mode == Z80_REGISTER_MODE_IY)*/
-					instruction->address = ((((cc_u16f)z80->state->iyh << 8) | z80->state->iyl) + displacement) & 0xFFFF;
+					instruction->address = (z80->state->iy + displacement) & 0xFFFF;
 
 				/* TODO: Use a separate lookup for double-prefix mode? */
 			#ifdef Z80_PRECOMPUTE_INSTRUCTION_METADATA
@@ -1015,23 +1179,23 @@ static void DecodeInstruction(const Z80* const z80, const Z80_ReadAndWriteCallba
 				break;
 
 			case Z80_OPERAND_BC_INDIRECT:
-				instruction->address = ((cc_u16f)z80->state->b << 8) | z80->state->c;
+				instruction->address = z80->state->bc;
 				break;
 
 			case Z80_OPERAND_DE_INDIRECT:
-				instruction->address = ((cc_u16f)z80->state->d << 8) | z80->state->e;
+				instruction->address = z80->state->de;
 				break;
 
 			case Z80_OPERAND_HL_INDIRECT:
-				instruction->address = ((cc_u16f)z80->state->h << 8) | z80->state->l;
+				instruction->address = z80->state->hl;
 				break;
 
 			case Z80_OPERAND_IX_INDIRECT:
-				instruction->address = ((((cc_u16f)z80->state->ixh << 8) | z80->state->ixl) + displacement) & 0xFFFF;
+				instruction->address = (z80->state->ix + displacement) & 0xFFFF;
 				break;
 
 			case Z80_OPERAND_IY_INDIRECT:
-				instruction->address = ((((cc_u16f)z80->state->iyh << 8) | z80->state->iyl) + displacement) & 0xFFFF;
+				instruction->address = (z80->state->iy + displacement) & 0xFFFF;
 				break;
 
 			case Z80_OPERAND_ADDRESS:
@@ -1069,6 +1233,233 @@ static void DecodeInstruction(const Z80* const z80, const Z80_ReadAndWriteCallba
 
 #define WRITE_DESTINATION WriteOperand(z80, callbacks, instruction, (Z80_Operand)instruction->metadata->operands[1], result_value)
 
+/* Leaves the flags to be calculated by 'Z80_GetFlags' if they are needed. */
+#define DEFER_FLAGS(operation, result) \
+	z80->state->flags_operation = operation; \
+	z80->state->flags_source = source_value & 0xFF; \
+	z80->state->flags_destination = destination_value; \
+	z80->state->flags_result = (result) & 0x1FF
+
+/* The bodies of instructions which have specialised variants. These expect 'source_value' or 'destination_value' to already be set. */
+#define ALU_ADD_A \
+	destination_value = z80->state->a; \
+\
+	result_value_with_carry = destination_value + source_value; \
+	result_value = result_value_with_carry & 0xFF; \
+\
+	DEFER_FLAGS(FLAGS_OPERATION_ADD, result_value_with_carry); \
+\
+	z80->state->a = result_value
+
+#define ALU_ADC_A \
+	destination_value = z80->state->a; \
+\
+	result_value_with_carry = destination_value + source_value + ((z80->state->f & FLAG_MASK_CARRY) != 0 ? 1 : 0); \
+	result_value = result_value_with_carry & 0xFF; \
+\
+	z80->state->f = 0; \
+	CONDITION_CARRY; \
+	CONDITION_SIGN; \
+	CONDITION_ZERO; \
+	CONDITION_HALF_CARRY; \
+	CONDITION_OVERFLOW; \
+\
+	z80->state->a = result_value
+
+#define ALU_SUB \
+	source_value = ~source_value; \
+	destination_value = z80->state->a; \
+\
+	result_value_with_carry = destination_value + source_value + 1; \
+	result_value = result_value_with_carry & 0xFF; \
+\
+	DEFER_FLAGS(FLAGS_OPERATION_SUBTRACT, result_value_with_carry); \
+\
+	z80->state->a = result_value
+
+#define ALU_SBC_A \
+	source_value = ~source_value; \
+	destination_value = z80->state->a; \
+\
+	result_value_with_carry = destination_value + source_value + ((z80->state->f & FLAG_MASK_CARRY) != 0 ? 0 : 1); \
+	result_value = result_value_with_carry & 0xFF; \
+\
+	z80->state->f = 0; \
+	CONDITION_CARRY; \
+	CONDITION_SIGN; \
+	CONDITION_ZERO; \
+	CONDITION_HALF_CARRY; \
+	CONDITION_OVERFLOW; \
+\
+	z80->state->f ^= FLAG_MASK_HALF_CARRY; \
+	z80->state->f |= FLAG_MASK_ADD_SUBTRACT; \
+\
+	z80->state->a = result_value
+
+#define ALU_AND \
+	destination_value = z80->state->a; \
+\
+	result_value = destination_value & source_value; \
+\
+	DEFER_FLAGS(FLAGS_OPERATION_AND, result_value); \
+\
+	z80->state->a = result_value
+
+#define ALU_XOR \
+	destination_value = z80->state->a; \
+\
+	result_value = destination_value ^ source_value; \
+\
+	DEFER_FLAGS(FLAGS_OPERATION_OR, result_value); \
+\
+	z80->state->a = result_value
+
+#define ALU_OR \
+	destination_value = z80->state->a; \
+\
+	result_value = destination_value | source_value; \
+\
+	DEFER_FLAGS(FLAGS_OPERATION_OR, result_value); \
+\
+	z80->state->a = result_value
+
+#define ALU_CP \
+	source_value = ~source_value; \
+	destination_value = z80->state->a; \
+\
+	result_value_with_carry = destination_value + source_value + 1; \
+	result_value = result_value_with_carry & 0xFF; \
+\
+	DEFER_FLAGS(FLAGS_OPERATION_SUBTRACT, result_value_with_carry)
+
+#define INC_8BIT \
+	source_value = 1; \
+	result_value = (destination_value + source_value) & 0xFF; \
+\
+	z80->state->f &= FLAG_MASK_CARRY; \
+\
+	CONDITION_SIGN; \
+	CONDITION_ZERO; \
+	CONDITION_HALF_CARRY; \
+	CONDITION_OVERFLOW
+
+#define DEC_8BIT \
+	source_value = -1; \
+	result_value = (destination_value + source_value) & 0xFF; \
+\
+	z80->state->f &= FLAG_MASK_CARRY; \
+\
+	CONDITION_SIGN; \
+	CONDITION_ZERO; \
+	CONDITION_HALF_CARRY; \
+	CONDITION_OVERFLOW; \
+\
+	z80->state->f ^= FLAG_MASK_HALF_CARRY; \
+	z80->state->f |= FLAG_MASK_ADD_SUBTRACT
+
+/* Templates for generating the specialised instruction variants. The operand indices match `GetSpecialisedOperandIndex`. */
+#define SPECIALISED_REGISTERS(MACRO, PARAMETER_1, PARAMETER_2) \
+	MACRO(PARAMETER_1, PARAMETER_2, 0, z80->state->a) \
+	MACRO(PARAMETER_1, PARAMETER_2, 1, HIGH_BYTE(z80->state->bc)) \
+	MACRO(PARAMETER_1, PARAMETER_2, 2, LOW_BYTE(z80->state->bc)) \
+	MACRO(PARAMETER_1, PARAMETER_2, 3, HIGH_BYTE(z80->state->de)) \
+	MACRO(PARAMETER_1, PARAMETER_2, 4, LOW_BYTE(z80->state->de)) \
+	MACRO(PARAMETER_1, PARAMETER_2, 5, HIGH_BYTE(z80->state->hl)) \
+	MACRO(PARAMETER_1, PARAMETER_2, 6, LOW_BYTE(z80->state->hl))
+
+/* Writes to the registers above, by index. */
+#define SET_SPECIALISED_REGISTER_0(value) z80->state->a = (value)
+#define SET_SPECIALISED_REGISTER_1(value) SET_HIGH_BYTE(z80->state->bc, value)
+#define SET_SPECIALISED_REGISTER_2(value) SET_LOW_BYTE(z80->state->bc, value)
+#define SET_SPECIALISED_REGISTER_3(value) SET_HIGH_BYTE(z80->state->de, value)
+#define SET_SPECIALISED_REGISTER_4(value) SET_LOW_BYTE(z80->state->de, value)
+#define SET_SPECIALISED_REGISTER_5(value) SET_HIGH_BYTE(z80->state->hl, value)
+#define SET_SPECIALISED_REGISTER_6(value) SET_LOW_BYTE(z80->state->hl, value)
+
+#define SPECIALISED_SOURCES(MACRO, PARAMETER_1, PARAMETER_2) \
+	SPECIALISED_REGISTERS(MACRO, PARAMETER_1, PARAMETER_2) \
+	MACRO(PARAMETER_1, PARAMETER_2, 7, MemoryRead(z80, callbacks, instruction->address)) \
+	MACRO(PARAMETER_1, PARAMETER_2, 8, instruction->literal)
+
+#define SPECIALISED_LD_8BIT_CASE(DESTINATION_INDEX, DESTINATION, SOURCE_INDEX, SOURCE) \
+		case HANDLER_LD_8BIT_FIRST + DESTINATION_INDEX * HANDLER_SPECIALISED_OPERANDS + SOURCE_INDEX: \
+			DESTINATION(SOURCE); \
+			break;
+
+#define SPECIALISED_LD_8BIT_TO_MEMORY_CASE(UNUSED_1, UNUSED_2, SOURCE_INDEX, SOURCE) \
+		case HANDLER_LD_8BIT_FIRST + 7 * HANDLER_SPECIALISED_OPERANDS + SOURCE_INDEX: \
+			MemoryWrite(z80, callbacks, instruction->address, SOURCE); \
+			break;
+
+#define SPECIALISED_ALU_CASE(OPERATION_INDEX, OPERATION, SOURCE_INDEX, SOURCE) \
+		case HANDLER_ALU_FIRST + OPERATION_INDEX * HANDLER_SPECIALISED_OPERANDS + SOURCE_INDEX: \
+			source_value = SOURCE; \
+			OPERATION; \
+			break;
+
+#define SPECIALISED_INC_DEC_8BIT_CASE(FIRST, OPERATION, REGISTER_INDEX, REGISTER) \
+		case FIRST + REGISTER_INDEX: \
+			destination_value = REGISTER; \
+			OPERATION; \
+			SET_SPECIALISED_REGISTER_##REGISTER_INDEX(result_value); \
+			break;
+
+static cc_bool HandlerPreservesDeferredFlags(const cc_u8f handler)
+{
+	/* Returns whether a handler neither reads nor writes 'f', so that deferred flags can be left alone. */
+	if (handler >= HANDLER_LD_8BIT_FIRST && handler < HANDLER_ALU_FIRST)
+		return cc_true;
+
+	if (handler >= HANDLER_ALU_FIRST && handler < HANDLER_INC_8BIT_FIRST)
+	{
+		const cc_u8f opcode = Z80_OPCODE_ADD_A + (handler - HANDLER_ALU_FIRST) / HANDLER_SPECIALISED_OPERANDS;
+
+		/* These need the carry flag. */
+		return opcode != Z80_OPCODE_ADC_A && opcode != Z80_OPCODE_SBC_A;
+	}
+
+	switch (handler)
+	{
+		case Z80_OPCODE_NOP:
+		case Z80_OPCODE_DJNZ:
+		case Z80_OPCODE_JR_UNCONDITIONAL:
+		case Z80_OPCODE_JR_CONDITIONAL:
+		case Z80_OPCODE_LD_16BIT:
+		case Z80_OPCODE_LD_8BIT:
+		case Z80_OPCODE_INC_16BIT:
+		case Z80_OPCODE_DEC_16BIT:
+		case Z80_OPCODE_ADD_A:
+		case Z80_OPCODE_SUB:
+		case Z80_OPCODE_AND:
+		case Z80_OPCODE_XOR:
+		case Z80_OPCODE_OR:
+		case Z80_OPCODE_CP:
+		case Z80_OPCODE_RET_CONDITIONAL:
+		case Z80_OPCODE_POP:
+		case Z80_OPCODE_RET_UNCONDITIONAL:
+		case Z80_OPCODE_EXX:
+		case Z80_OPCODE_JP_HL:
+		case Z80_OPCODE_LD_SP_HL:
+		case Z80_OPCODE_JP_CONDITIONAL:
+		case Z80_OPCODE_JP_UNCONDITIONAL:
+		case Z80_OPCODE_OUT:
+		case Z80_OPCODE_EX_SP_HL:
+		case Z80_OPCODE_EX_DE_HL:
+		case Z80_OPCODE_DI:
+		case Z80_OPCODE_EI:
+		case Z80_OPCODE_CALL_CONDITIONAL:
+		case Z80_OPCODE_PUSH:
+		case Z80_OPCODE_CALL_UNCONDITIONAL:
+		case Z80_OPCODE_DD_PREFIX:
+		case Z80_OPCODE_FD_PREFIX:
+		case Z80_OPCODE_RST:
+			return cc_true;
+
+		default:
+			return cc_false;
+	}
+}
+
 static void ExecuteInstruction(const Z80* const z80, const Z80_ReadAndWriteCallbacks* const callbacks, const Z80Instruction* const instruction)
 {
 	cc_u16f source_value;
@@ -1076,12 +1467,15 @@ static void ExecuteInstruction(const Z80* const z80, const Z80_ReadAndWriteCallb
 	cc_u16f result_value;
 	cc_u16f result_value_with_carry;
 	cc_u32f result_value_with_carry_16bit;
-	cc_u8l swap_holder;
+	cc_u16l swap_holder;
 	cc_bool carry;
 
 	z80->state->register_mode = Z80_REGISTER_MODE_HL;
 
-	switch ((Z80_Opcode)instruction->metadata->opcode)
+	if (z80->state->flags_operation != FLAGS_OPERATION_NONE && !HandlerPreservesDeferredFlags(instruction->metadata->handler))
+		MaterialiseFlags(z80);
+
+	switch (instruction->metadata->handler)
 	{
 		#define UNIMPLEMENTED_Z80_INSTRUCTION(instruction) LogMessage("Unimplemented instruction " instruction " used at 0x%" CC_PRIXLEAST16, z80->state->program_counter)
 
@@ -1098,10 +1492,9 @@ static void ExecuteInstruction(const Z80* const z80, const Z80_ReadAndWriteCallb
 			/* This instruction takes an extra cycle. */
 			z80->state->cycles += 1;
 
-			--z80->state->b;
-			z80->state->b &= 0xFF;
+			z80->state->bc = (z80->state->bc - 0x100) & 0xFFFF;
 
-			if (z80->state->b != 0)
+			if (HIGH_BYTE(z80->state->bc) != 0)
 			{
 				z80->state->program_counter += CC_SIGN_EXTEND_UINT(7, instruction->literal);
 
@@ -1112,7 +1505,7 @@ static void ExecuteInstruction(const Z80* const z80, const Z80_ReadAndWriteCallb
 			break;
 
 		case Z80_OPCODE_JR_CONDITIONAL:
-			if (!EvaluateCondition(z80->state->f, (Z80_Condition)instruction->metadata->condition))
+			if (!EvaluateConditionDeferred(z80, (Z80_Condition)instruction->metadata->condition))
 				break;
 			/* Fallthrough */
 		case Z80_OPCODE_JR_UNCONDITIONAL:
@@ -1177,18 +1570,8 @@ static void ExecuteInstruction(const Z80* const z80, const Z80_ReadAndWriteCallb
 			break;
 
 		case Z80_OPCODE_INC_8BIT:
-			source_value = 1;
 			READ_DESTINATION;
-
-			result_value = (destination_value + source_value) & 0xFF;
-
-			z80->state->f &= FLAG_MASK_CARRY;
-
-			CONDITION_SIGN;
-			CONDITION_ZERO;
-			CONDITION_HALF_CARRY;
-			CONDITION_OVERFLOW;
-
+			INC_8BIT;
 			WRITE_DESTINATION;
 
 			/* The memory-accessing version takes an extra cycle. */
@@ -1199,21 +1582,8 @@ static void ExecuteInstruction(const Z80* const z80, const Z80_ReadAndWriteCallb
 			break;
 
 		case Z80_OPCODE_DEC_8BIT:
-			source_value = -1;
 			READ_DESTINATION;
-
-			result_value = (destination_value + source_value) & 0xFF;
-
-			z80->state->f &= FLAG_MASK_CARRY;
-
-			CONDITION_SIGN;
-			CONDITION_ZERO;
-			CONDITION_HALF_CARRY;
-			CONDITION_OVERFLOW;
-
-			z80->state->f ^= FLAG_MASK_HALF_CARRY;
-			z80->state->f |= FLAG_MASK_ADD_SUBTRACT;
-
+			DEC_8BIT;
 			WRITE_DESTINATION;
 
 			/* The memory-accessing version takes an extra cycle. */
@@ -1319,154 +1689,47 @@ static void ExecuteInstruction(const Z80* const z80, const Z80_ReadAndWriteCallb
 			break;
 
 		case Z80_OPCODE_HALT:
-			/* TODO */
-			UNIMPLEMENTED_Z80_INSTRUCTION("HALT");
+			z80->state->halted = cc_true;
 			break;
 
 		case Z80_OPCODE_ADD_A:
 			READ_SOURCE;
-			destination_value = z80->state->a;
-
-			result_value_with_carry = destination_value + source_value;
-			result_value = result_value_with_carry & 0xFF;
-
-			z80->state->f = 0;
-			CONDITION_CARRY;
-			CONDITION_SIGN;
-			CONDITION_ZERO;
-			CONDITION_HALF_CARRY;
-			CONDITION_OVERFLOW;
-
-			z80->state->a = result_value;
-
+			ALU_ADD_A;
 			break;
 
 		case Z80_OPCODE_ADC_A:
 			READ_SOURCE;
-			destination_value = z80->state->a;
-
-			result_value_with_carry = destination_value + source_value + ((z80->state->f & FLAG_MASK_CARRY) != 0 ? 1 : 0);
-			result_value = result_value_with_carry & 0xFF;
-
-			z80->state->f = 0;
-			CONDITION_CARRY;
-			CONDITION_SIGN;
-			CONDITION_ZERO;
-			CONDITION_HALF_CARRY;
-			CONDITION_OVERFLOW;
-
-			z80->state->a = result_value;
-
+			ALU_ADC_A;
 			break;
 
 		case Z80_OPCODE_SUB:
 			READ_SOURCE;
-			source_value = ~source_value;
-			destination_value = z80->state->a;
-
-			result_value_with_carry = destination_value + source_value + 1;
-			result_value = result_value_with_carry & 0xFF;
-
-			z80->state->f = 0;
-			CONDITION_CARRY;
-			CONDITION_SIGN;
-			CONDITION_ZERO;
-			CONDITION_HALF_CARRY;
-			CONDITION_OVERFLOW;
-
-			z80->state->f ^= FLAG_MASK_HALF_CARRY;
-			z80->state->f |= FLAG_MASK_ADD_SUBTRACT;
-
-			z80->state->a = result_value;
-
+			ALU_SUB;
 			break;
 
 		case Z80_OPCODE_SBC_A:
 			READ_SOURCE;
-			source_value = ~source_value;
-			destination_value = z80->state->a;
-
-			result_value_with_carry = destination_value + source_value + ((z80->state->f & FLAG_MASK_CARRY) != 0 ? 0 : 1);
-			result_value = result_value_with_carry & 0xFF;
-
-			z80->state->f = 0;
-			CONDITION_CARRY;
-			CONDITION_SIGN;
-			CONDITION_ZERO;
-			CONDITION_HALF_CARRY;
-			CONDITION_OVERFLOW;
-
-			z80->state->f ^= FLAG_MASK_HALF_CARRY;
-			z80->state->f |= FLAG_MASK_ADD_SUBTRACT;
-
-			z80->state->a = result_value;
-
+			ALU_SBC_A;
 			break;
 
 		case Z80_OPCODE_AND:
 			READ_SOURCE;
-			destination_value = z80->state->a;
-
-			result_value = destination_value & source_value;
-
-			z80->state->f = 0;
-			CONDITION_SIGN;
-			CONDITION_ZERO;
-			z80->state->f |= FLAG_MASK_HALF_CARRY;
-			CONDITION_PARITY;
-
-			z80->state->a = result_value;
-
+			ALU_AND;
 			break;
 
 		case Z80_OPCODE_XOR:
 			READ_SOURCE;
-			destination_value = z80->state->a;
-
-			result_value = destination_value ^ source_value;
-
-			z80->state->f = 0;
-			CONDITION_SIGN;
-			CONDITION_ZERO;
-			CONDITION_PARITY;
-
-			z80->state->a = result_value;
-
+			ALU_XOR;
 			break;
 
 		case Z80_OPCODE_OR:
 			READ_SOURCE;
-			destination_value = z80->state->a;
-
-			result_value = destination_value | source_value;
-
-			z80->state->f = 0;
-			CONDITION_SIGN;
-			CONDITION_ZERO;
-			CONDITION_PARITY;
-
-			z80->state->a = result_value;
-
+			ALU_OR;
 			break;
 
 		case Z80_OPCODE_CP:
 			READ_SOURCE;
-			source_value = ~source_value;
-			destination_value = z80->state->a;
-
-			result_value_with_carry = destination_value + source_value + 1;
-			result_value = result_value_with_carry & 0xFF;
-
-			z80->state->f = 0;
-			CONDITION_CARRY;
-			CONDITION_SIGN;
-			CONDITION_ZERO;
-			CONDITION_HALF_CARRY;
-			CONDITION_OVERFLOW;
-
-			z80->state->f ^= FLAG_MASK_HALF_CARRY;
-			z80->state->f |= FLAG_MASK_ADD_SUBTRACT;
-
+			ALU_CP;
 			break;
 
 		case Z80_OPCODE_POP:
@@ -1483,7 +1746,7 @@ static void ExecuteInstruction(const Z80* const z80, const Z80_ReadAndWriteCallb
 			/* This instruction requires an extra cycle. */
 			z80->state->cycles += 1;
 
-			if (!EvaluateCondition(z80->state->f, (Z80_Condition)instruction->metadata->condition))
+			if (!EvaluateConditionDeferred(z80, (Z80_Condition)instruction->metadata->condition))
 				break;
 			/* Fallthrough */
 		case Z80_OPCODE_RET_UNCONDITIONAL:
@@ -1495,12 +1758,9 @@ static void ExecuteInstruction(const Z80* const z80, const Z80_ReadAndWriteCallb
 			break;
 
 		case Z80_OPCODE_EXX:
-			SWAP(z80->state->b, z80->state->b_);
-			SWAP(z80->state->c, z80->state->c_);
-			SWAP(z80->state->d, z80->state->d_);
-			SWAP(z80->state->e, z80->state->e_);
-			SWAP(z80->state->h, z80->state->h_);
-			SWAP(z80->state->l, z80->state->l_);
+			SWAP(z80->state->bc, z80->state->bc_);
+			SWAP(z80->state->de, z80->state->de_);
+			SWAP(z80->state->hl, z80->state->hl_);
 			break;
 
 		case Z80_OPCODE_LD_SP_HL:
@@ -1514,7 +1774,7 @@ static void ExecuteInstruction(const Z80* const z80, const Z80_ReadAndWriteCallb
 			break;
 
 		case Z80_OPCODE_JP_CONDITIONAL:
-			if (!EvaluateCondition(z80->state->f, (Z80_Condition)instruction->metadata->condition))
+			if (!EvaluateConditionDeferred(z80, (Z80_Condition)instruction->metadata->condition))
 				break;
 			/* Fallthrough */
 		case Z80_OPCODE_JP_UNCONDITIONAL:
@@ -1560,8 +1820,7 @@ static void ExecuteInstruction(const Z80* const z80, const Z80_ReadAndWriteCallb
 			break;
 
 		case Z80_OPCODE_EX_DE_HL:
-			SWAP(z80->state->d, z80->state->h);
-			SWAP(z80->state->e, z80->state->l);
+			SWAP(z80->state->de, z80->state->hl);
 			break;
 
 		case Z80_OPCODE_DI:
@@ -1589,7 +1848,7 @@ static void ExecuteInstruction(const Z80* const z80, const Z80_ReadAndWriteCallb
 			break;
 
 		case Z80_OPCODE_CALL_CONDITIONAL:
-			if (!EvaluateCondition(z80->state->f, (Z80_Condition)instruction->metadata->condition))
+			if (!EvaluateConditionDeferred(z80, (Z80_Condition)instruction->metadata->condition))
 				break;
 			/* Fallthrough */
 		case Z80_OPCODE_CALL_UNCONDITIONAL:
@@ -1982,7 +2241,7 @@ static void ExecuteInstruction(const Z80* const z80, const Z80_ReadAndWriteCallb
 
 		case Z80_OPCODE_RRD:
 		{
-			const cc_u16f hl = ((cc_u16f)z80->state->h << 8) | z80->state->l;
+			const cc_u16f hl = z80->state->hl;
 			const cc_u8f hl_value = MemoryRead(z80, callbacks, hl);
 			const cc_u8f hl_high = (hl_value >> 4) & 0xF;
 			const cc_u8f hl_low = (hl_value >> 0) & 0xF;
@@ -2007,7 +2266,7 @@ static void ExecuteInstruction(const Z80* const z80, const Z80_ReadAndWriteCallb
 
 		case Z80_OPCODE_RLD:
 		{
-			const cc_u16f hl = ((cc_u16f)z80->state->h << 8) | z80->state->l;
+			const cc_u16f hl = z80->state->hl;
 			const cc_u8f hl_value = MemoryRead(z80, callbacks, hl);
 			const cc_u8f hl_high = (hl_value >> 4) & 0xF;
 			const cc_u8f hl_low = (hl_value >> 0) & 0xF;
@@ -2032,43 +2291,22 @@ static void ExecuteInstruction(const Z80* const z80, const Z80_ReadAndWriteCallb
 
 		case Z80_OPCODE_LDI:
 		{
-			const cc_u16f de = ((cc_u16f)z80->state->d << 8) | z80->state->e;
-			const cc_u16f hl = ((cc_u16f)z80->state->h << 8) | z80->state->l;
+			const cc_u16f de = z80->state->de;
+			const cc_u16f hl = z80->state->hl;
 
 			MemoryWrite(z80, callbacks, de, MemoryRead(z80, callbacks, hl));
 
 			/* Increment 'hl'. */
-			++z80->state->l;
-			z80->state->l &= 0xFF;
-
-			if (z80->state->l == 0)
-			{
-				++z80->state->h;
-				z80->state->h &= 0xFF;
-			}
+			z80->state->hl = (z80->state->hl + 1) & 0xFFFF;
 
 			/* Increment 'de'. */
-			++z80->state->e;
-			z80->state->e &= 0xFF;
-
-			if (z80->state->e == 0)
-			{
-				++z80->state->d;
-				z80->state->d &= 0xFF;
-			}
+			z80->state->de = (z80->state->de + 1) & 0xFFFF;
 
 			/* Decrement 'bc'. */
-			--z80->state->c;
-			z80->state->c &= 0xFF;
-
-			if (z80->state->c == 0xFF)
-			{
-				--z80->state->b;
-				z80->state->b &= 0xFF;
-			}
+			z80->state->bc = (z80->state->bc - 1) & 0xFFFF;
 
 			z80->state->f &= FLAG_MASK_CARRY | FLAG_MASK_ZERO | FLAG_MASK_SIGN;
-			z80->state->f |= (z80->state->b | z80->state->c) != 0 ? FLAG_MASK_PARITY_OVERFLOW : 0;
+			z80->state->f |= z80->state->bc != 0 ? FLAG_MASK_PARITY_OVERFLOW : 0;
 
 			/* This instruction requires an extra 2 cycles. */
 			z80->state->cycles += 2;
@@ -2078,43 +2316,22 @@ static void ExecuteInstruction(const Z80* const z80, const Z80_ReadAndWriteCallb
 
 		case Z80_OPCODE_LDD:
 		{
-			const cc_u16f de = ((cc_u16f)z80->state->d << 8) | z80->state->e;
-			const cc_u16f hl = ((cc_u16f)z80->state->h << 8) | z80->state->l;
+			const cc_u16f de = z80->state->de;
+			const cc_u16f hl = z80->state->hl;
 
 			MemoryWrite(z80, callbacks, de, MemoryRead(z80, callbacks, hl));
 
 			/* Decrement 'hl'. */
-			--z80->state->l;
-			z80->state->l &= 0xFF;
-
-			if (z80->state->l == 0xFF)
-			{
-				--z80->state->h;
-				z80->state->h &= 0xFF;
-			}
+			z80->state->hl = (z80->state->hl - 1) & 0xFFFF;
 
 			/* Decrement 'de'. */
-			--z80->state->e;
-			z80->state->e &= 0xFF;
-
-			if (z80->state->e == 0xFF)
-			{
-				--z80->state->d;
-				z80->state->d &= 0xFF;
-			}
+			z80->state->de = (z80->state->de - 1) & 0xFFFF;
 
 			/* Decrement 'bc'. */
-			--z80->state->c;
-			z80->state->c &= 0xFF;
-
-			if (z80->state->c == 0xFF)
-			{
-				--z80->state->b;
-				z80->state->b &= 0xFF;
-			}
+			z80->state->bc = (z80->state->bc - 1) & 0xFFFF;
 
 			z80->state->f &= FLAG_MASK_CARRY | FLAG_MASK_ZERO | FLAG_MASK_SIGN;
-			z80->state->f |= (z80->state->b | z80->state->c) != 0 ? FLAG_MASK_PARITY_OVERFLOW : 0;
+			z80->state->f |= z80->state->bc != 0 ? FLAG_MASK_PARITY_OVERFLOW : 0;
 
 			/* This instruction requires an extra 2 cycles. */
 			z80->state->cycles += 2;
@@ -2124,43 +2341,22 @@ static void ExecuteInstruction(const Z80* const z80, const Z80_ReadAndWriteCallb
 
 		case Z80_OPCODE_LDIR:
 		{
-			const cc_u16f de = ((cc_u16f)z80->state->d << 8) | z80->state->e;
-			const cc_u16f hl = ((cc_u16f)z80->state->h << 8) | z80->state->l;
+			const cc_u16f de = z80->state->de;
+			const cc_u16f hl = z80->state->hl;
 
 			MemoryWrite(z80, callbacks, de, MemoryRead(z80, callbacks, hl));
 
 			/* Increment 'hl'. */
-			++z80->state->l;
-			z80->state->l &= 0xFF;
-
-			if (z80->state->l == 0)
-			{
-				++z80->state->h;
-				z80->state->h &= 0xFF;
-			}
+			z80->state->hl = (z80->state->hl + 1) & 0xFFFF;
 
 			/* Increment 'de'. */
-			++z80->state->e;
-			z80->state->e &= 0xFF;
-
-			if (z80->state->e == 0)
-			{
-				++z80->state->d;
-				z80->state->d &= 0xFF;
-			}
+			z80->state->de = (z80->state->de + 1) & 0xFFFF;
 
 			/* Decrement 'bc'. */
-			--z80->state->c;
-			z80->state->c &= 0xFF;
-
-			if (z80->state->c == 0xFF)
-			{
-				--z80->state->b;
-				z80->state->b &= 0xFF;
-			}
+			z80->state->bc = (z80->state->bc - 1) & 0xFFFF;
 
 			z80->state->f &= FLAG_MASK_CARRY | FLAG_MASK_ZERO | FLAG_MASK_SIGN;
-			z80->state->f |= (z80->state->b | z80->state->c) != 0 ? FLAG_MASK_PARITY_OVERFLOW : 0;
+			z80->state->f |= z80->state->bc != 0 ? FLAG_MASK_PARITY_OVERFLOW : 0;
 
 			/* This instruction requires an extra 2 cycles. */
 			z80->state->cycles += 2;
@@ -2178,43 +2374,22 @@ static void ExecuteInstruction(const Z80* const z80, const Z80_ReadAndWriteCallb
 
 		case Z80_OPCODE_LDDR:
 		{
-			const cc_u16f de = ((cc_u16f)z80->state->d << 8) | z80->state->e;
-			const cc_u16f hl = ((cc_u16f)z80->state->h << 8) | z80->state->l;
+			const cc_u16f de = z80->state->de;
+			const cc_u16f hl = z80->state->hl;
 
 			MemoryWrite(z80, callbacks, de, MemoryRead(z80, callbacks, hl));
 
 			/* Decrement 'hl'. */
-			--z80->state->l;
-			z80->state->l &= 0xFF;
-
-			if (z80->state->l == 0xFF)
-			{
-				--z80->state->h;
-				z80->state->h &= 0xFF;
-			}
+			z80->state->hl = (z80->state->hl - 1) & 0xFFFF;
 
 			/* Decrement 'de'. */
-			--z80->state->e;
-			z80->state->e &= 0xFF;
-
-			if (z80->state->e == 0xFF)
-			{
-				--z80->state->d;
-				z80->state->d &= 0xFF;
-			}
+			z80->state->de = (z80->state->de - 1) & 0xFFFF;
 
 			/* Decrement 'bc'. */
-			--z80->state->c;
-			z80->state->c &= 0xFF;
-
-			if (z80->state->c == 0xFF)
-			{
-				--z80->state->b;
-				z80->state->b &= 0xFF;
-			}
+			z80->state->bc = (z80->state->bc - 1) & 0xFFFF;
 
 			z80->state->f &= FLAG_MASK_CARRY | FLAG_MASK_ZERO | FLAG_MASK_SIGN;
-			z80->state->f |= (z80->state->b | z80->state->c) != 0 ? FLAG_MASK_PARITY_OVERFLOW : 0;
+			z80->state->f |= z80->state->bc != 0 ? FLAG_MASK_PARITY_OVERFLOW : 0;
 
 			/* This instruction requires an extra 2 cycles. */
 			z80->state->cycles += 2;
@@ -2232,34 +2407,20 @@ static void ExecuteInstruction(const Z80* const z80, const Z80_ReadAndWriteCallb
 
 		case Z80_OPCODE_CPI:
 		{
-			const cc_u16f hl = ((cc_u16f)z80->state->h << 8) | z80->state->l;
+			const cc_u16f hl = z80->state->hl;
 
 			source_value = MemoryRead(z80, callbacks, hl);
 			destination_value = z80->state->a;
 			result_value = destination_value - source_value;
 
 			/* Increment 'hl'. */
-			++z80->state->l;
-			z80->state->l &= 0xFF;
-
-			if (z80->state->l == 0)
-			{
-				++z80->state->h;
-				z80->state->h &= 0xFF;
-			}
+			z80->state->hl = (z80->state->hl + 1) & 0xFFFF;
 
 			/* Decrement 'bc'. */
-			--z80->state->c;
-			z80->state->c &= 0xFF;
-
-			if (z80->state->c == 0xFF)
-			{
-				--z80->state->b;
-				z80->state->b &= 0xFF;
-			}
+			z80->state->bc = (z80->state->bc - 1) & 0xFFFF;
 
 			z80->state->f &= FLAG_MASK_CARRY;
-			z80->state->f |= (z80->state->b | z80->state->c) != 0 ? FLAG_MASK_PARITY_OVERFLOW : 0;
+			z80->state->f |= z80->state->bc != 0 ? FLAG_MASK_PARITY_OVERFLOW : 0;
 			CONDITION_SIGN;
 			CONDITION_ZERO;
 			CONDITION_HALF_CARRY;
@@ -2274,34 +2435,20 @@ static void ExecuteInstruction(const Z80* const z80, const Z80_ReadAndWriteCallb
 
 		case Z80_OPCODE_CPD:
 		{
-			const cc_u16f hl = ((cc_u16f)z80->state->h << 8) | z80->state->l;
+			const cc_u16f hl = z80->state->hl;
 
 			source_value = MemoryRead(z80, callbacks, hl);
 			destination_value = z80->state->a;
 			result_value = destination_value - source_value;
 
 			/* Decrement 'hl'. */
-			--z80->state->l;
-			z80->state->l &= 0xFF;
-
-			if (z80->state->l == 0xFF)
-			{
-				--z80->state->h;
-				z80->state->h &= 0xFF;
-			}
+			z80->state->hl = (z80->state->hl - 1) & 0xFFFF;
 
 			/* Decrement 'bc'. */
-			--z80->state->c;
-			z80->state->c &= 0xFF;
-
-			if (z80->state->c == 0xFF)
-			{
-				--z80->state->b;
-				z80->state->b &= 0xFF;
-			}
+			z80->state->bc = (z80->state->bc - 1) & 0xFFFF;
 
 			z80->state->f &= FLAG_MASK_CARRY;
-			z80->state->f |= (z80->state->b | z80->state->c) != 0 ? FLAG_MASK_PARITY_OVERFLOW : 0;
+			z80->state->f |= z80->state->bc != 0 ? FLAG_MASK_PARITY_OVERFLOW : 0;
 			CONDITION_SIGN;
 			CONDITION_ZERO;
 			CONDITION_HALF_CARRY;
@@ -2316,34 +2463,20 @@ static void ExecuteInstruction(const Z80* const z80, const Z80_ReadAndWriteCallb
 
 		case Z80_OPCODE_CPIR:
 		{
-			const cc_u16f hl = ((cc_u16f)z80->state->h << 8) | z80->state->l;
+			const cc_u16f hl = z80->state->hl;
 
 			source_value = MemoryRead(z80, callbacks, hl);
 			destination_value = z80->state->a;
 			result_value = destination_value - source_value;
 
 			/* Increment 'hl'. */
-			++z80->state->l;
-			z80->state->l &= 0xFF;
-
-			if (z80->state->l == 0)
-			{
-				++z80->state->h;
-				z80->state->h &= 0xFF;
-			}
+			z80->state->hl = (z80->state->hl + 1) & 0xFFFF;
 
 			/* Decrement 'bc'. */
-			--z80->state->c;
-			z80->state->c &= 0xFF;
-
-			if (z80->state->c == 0xFF)
-			{
-				--z80->state->b;
-				z80->state->b &= 0xFF;
-			}
+			z80->state->bc = (z80->state->bc - 1) & 0xFFFF;
 
 			z80->state->f &= FLAG_MASK_CARRY;
-			z80->state->f |= (z80->state->b | z80->state->c) != 0 ? FLAG_MASK_PARITY_OVERFLOW : 0;
+			z80->state->f |= z80->state->bc != 0 ? FLAG_MASK_PARITY_OVERFLOW : 0;
 			CONDITION_SIGN;
 			CONDITION_ZERO;
 			CONDITION_HALF_CARRY;
@@ -2366,34 +2499,20 @@ static void ExecuteInstruction(const Z80* const z80, const Z80_ReadAndWriteCallb
 
 		case Z80_OPCODE_CPDR:
 		{
-			const cc_u16f hl = ((cc_u16f)z80->state->h << 8) | z80->state->l;
+			const cc_u16f hl = z80->state->hl;
 
 			source_value = MemoryRead(z80, callbacks, hl);
 			destination_value = z80->state->a;
 			result_value = destination_value - source_value;
 
 			/* Decrement 'hl'. */
-			--z80->state->l;
-			z80->state->l &= 0xFF;
-
-			if (z80->state->l == 0xFF)
-			{
-				--z80->state->h;
-				z80->state->h &= 0xFF;
-			}
+			z80->state->hl = (z80->state->hl - 1) & 0xFFFF;
 
 			/* Decrement 'bc'. */
-			--z80->state->c;
-			z80->state->c &= 0xFF;
-
-			if (z80->state->c == 0xFF)
-			{
-				--z80->state->b;
-				z80->state->b &= 0xFF;
-			}
+			z80->state->bc = (z80->state->bc - 1) & 0xFFFF;
 
 			z80->state->f &= FLAG_MASK_CARRY;
-			z80->state->f |= (z80->state->b | z80->state->c) != 0 ? FLAG_MASK_PARITY_OVERFLOW : 0;
+			z80->state->f |= z80->state->bc != 0 ? FLAG_MASK_PARITY_OVERFLOW : 0;
 			CONDITION_SIGN;
 			CONDITION_ZERO;
 			CONDITION_HALF_CARRY;
@@ -2447,6 +2566,29 @@ static void ExecuteInstruction(const Z80* const z80, const Z80_ReadAndWriteCallb
 			break;
 
 		#undef UNIMPLEMENTED_Z80_INSTRUCTION
+
+		/* Specialised variants. */
+		SPECIALISED_SOURCES(SPECIALISED_LD_8BIT_CASE, 0, SET_SPECIALISED_REGISTER_0)
+		SPECIALISED_SOURCES(SPECIALISED_LD_8BIT_CASE, 1, SET_SPECIALISED_REGISTER_1)
+		SPECIALISED_SOURCES(SPECIALISED_LD_8BIT_CASE, 2, SET_SPECIALISED_REGISTER_2)
+		SPECIALISED_SOURCES(SPECIALISED_LD_8BIT_CASE, 3, SET_SPECIALISED_REGISTER_3)
+		SPECIALISED_SOURCES(SPECIALISED_LD_8BIT_CASE, 4, SET_SPECIALISED_REGISTER_4)
+		SPECIALISED_SOURCES(SPECIALISED_LD_8BIT_CASE, 5, SET_SPECIALISED_REGISTER_5)
+		SPECIALISED_SOURCES(SPECIALISED_LD_8BIT_CASE, 6, SET_SPECIALISED_REGISTER_6)
+		SPECIALISED_REGISTERS(SPECIALISED_LD_8BIT_TO_MEMORY_CASE, 0, 0)
+		SPECIALISED_LD_8BIT_TO_MEMORY_CASE(0, 0, 8, instruction->literal)
+
+		SPECIALISED_SOURCES(SPECIALISED_ALU_CASE, 0, ALU_ADD_A)
+		SPECIALISED_SOURCES(SPECIALISED_ALU_CASE, 1, ALU_ADC_A)
+		SPECIALISED_SOURCES(SPECIALISED_ALU_CASE, 2, ALU_SUB)
+		SPECIALISED_SOURCES(SPECIALISED_ALU_CASE, 3, ALU_SBC_A)
+		SPECIALISED_SOURCES(SPECIALISED_ALU_CASE, 4, ALU_AND)
+		SPECIALISED_SOURCES(SPECIALISED_ALU_CASE, 5, ALU_XOR)
+		SPECIALISED_SOURCES(SPECIALISED_ALU_CASE, 6, ALU_OR)
+		SPECIALISED_SOURCES(SPECIALISED_ALU_CASE, 7, ALU_CP)
+
+		SPECIALISED_REGISTERS(SPECIALISED_INC_DEC_8BIT_CASE, HANDLER_INC_8BIT_FIRST, INC_8BIT)
+		SPECIALISED_REGISTERS(SPECIALISED_INC_DEC_8BIT_CASE, HANDLER_DEC_8BIT_FIRST, DEC_8BIT)
 	}
 }
 
@@ -2473,16 +2615,7 @@ void Z80_Constant_Initialise(Z80_Constant* const constant)
 	/* Compute parity lookup table. */
 	for (i = 0; i < CC_COUNT_OF(constant->parity_lookup); ++i)
 	{
-		/* http://graphics.stanford.edu/~seander/bithacks.html#ParityMultiply */
-		/* I have absolutely no idea how this works. */
-		cc_u16f v;
-
-		v = i;
-		v ^= v >> 1;
-		v ^= v >> 2;
-		v = (v & 0x11) * 0x11;
-
-		constant->parity_lookup[i] = (v & 0x10) == 0 ? FLAG_MASK_PARITY_OVERFLOW : 0;
+		constant->parity_lookup[i] = GetParityFlag(i);
 	}
 }
 
@@ -2497,6 +2630,9 @@ void Z80_State_Initialise(Z80_State* const state)
 
 	/* Update on the next cycle. */
 	state->cycles = 1;
+	state->run_cycles = 0;
+
+	state->flags_operation = FLAGS_OPERATION_NONE;
 }
 
 void Z80_Reset(const Z80* const z80)
@@ -2510,6 +2646,8 @@ void Z80_Reset(const Z80* const z80)
 	z80->state->interrupts_enabled = cc_false;
 
 	z80->state->interrupt_pending = cc_false;
+
+	z80->state->halted = cc_false;
 }
 
 void Z80_Interrupt(const Z80* const z80, const cc_bool assert_interrupt)
@@ -2517,34 +2655,176 @@ void Z80_Interrupt(const Z80* const z80, const cc_bool assert_interrupt)
 	z80->state->interrupt_pending = assert_interrupt;
 }
 
-cc_u16f Z80_DoCycle(const Z80* const z80, const Z80_ReadAndWriteCallbacks* const callbacks)
+static cc_u16f GetBlockInstructionOpcode(const Z80_Opcode opcode)
+{
+	/* The second byte of the instruction (the first is always 0xED). */
+	switch (opcode)
+	{
+		case Z80_OPCODE_LDIR:
+			return 0xB0;
+
+		case Z80_OPCODE_CPIR:
+			return 0xB1;
+
+		case Z80_OPCODE_LDDR:
+			return 0xB8;
+
+		case Z80_OPCODE_CPDR:
+			return 0xB9;
+
+		default:
+			return 0;
+	}
+}
+
+static cc_u32f SkipBlockInstructionIterations(const Z80* const z80, const Z80_ReadAndWriteCallbacks* const callbacks, const Z80_Opcode opcode, const cc_u32f maximum_iterations)
+{
+	/* Performs iterations of a repeating block instruction directly on memory, stopping before the final one.
+	   The flags of these iterations are not needed, as the iteration after them overwrites them. */
+	const cc_u16f program_counter = z80->state->program_counter;
+	const cc_bool increment = opcode == Z80_OPCODE_LDIR || opcode == Z80_OPCODE_CPIR;
+	const cc_u16f bc = z80->state->bc;
+	const cc_u16f hl = z80->state->hl;
+
+	cc_u16f de = z80->state->de;
+	cc_u32f iterations;
+	cc_u32f i;
+
+	/* A 'bc' of 0 is 0x10000 iterations. */
+	iterations = CC_MIN(maximum_iterations, (bc - 1) & 0xFFFF);
+
+	/* Do not leave memory. */
+	if (hl >= callbacks->memory_size)
+		return 0;
+
+	iterations = CC_MIN(iterations, increment ? callbacks->memory_size - hl : hl + 1);
+
+	if (opcode == Z80_OPCODE_LDIR || opcode == Z80_OPCODE_LDDR)
+	{
+		if (de >= callbacks->memory_size)
+			return 0;
+
+		iterations = CC_MIN(iterations, increment ? callbacks->memory_size - de : de + 1);
+
+		/* Do not overwrite the instruction itself. */
+		if (increment && de < program_counter + 2 && de + iterations > program_counter)
+			iterations = de < program_counter ? program_counter - de : 0;
+		else if (!increment && de >= program_counter && de + 1 < program_counter + 2 + iterations)
+			iterations = de > program_counter + 1 ? de - (program_counter + 1) : 0;
+
+		/* This must be done a byte at a time, as overlapping copies are used to fill memory. */
+		for (i = 0; i < iterations; ++i)
+		{
+			if (increment)
+				callbacks->memory[de + i] = callbacks->memory[hl + i];
+			else
+				callbacks->memory[de - i] = callbacks->memory[hl - i];
+		}
+
+		de = increment ? de + iterations : de - iterations;
+		z80->state->de = de & 0xFFFF;
+	}
+	else
+	{
+		/* Stop before the iteration that finds a match. */
+		for (i = 0; i < iterations; ++i)
+			if (callbacks->memory[increment ? hl + i : hl - i] == z80->state->a)
+				break;
+
+		iterations = i;
+	}
+
+	z80->state->hl = (increment ? hl + iterations : hl - iterations) & 0xFFFF;
+	z80->state->bc = (bc - iterations) & 0xFFFF;
+
+	return iterations;
+}
+
+static void RepeatBlockInstruction(const Z80* const z80, const Z80_ReadAndWriteCallbacks* const callbacks, const Z80Instruction* const instruction, const cc_u32f cycles_available)
+{
+	/* Repeating block instructions (LDIR and friends) work by re-executing themselves. Since nothing can interrupt
+	   them partway through a run, do that here instead of decoding them again for every iteration. */
+	const Z80_Opcode opcode = (Z80_Opcode)instruction->metadata->opcode;
+	const cc_u16f program_counter = z80->state->program_counter;
+	const cc_u16f opcode_byte = GetBlockInstructionOpcode(opcode);
+	const cc_u32f iteration_cycles = z80->state->cycles;
+	const cc_u16f run_cycles = z80->state->run_cycles;
+
+	if (opcode_byte == 0)
+		return;
+
+	/* The instruction must be re-fetched from memory without side-effects, and may have overwritten itself. */
+	while (z80->state->program_counter == program_counter
+		&& z80->state->cycles < cycles_available
+		&& program_counter + 1 < callbacks->memory_size
+		&& callbacks->memory[program_counter] == 0xED
+		&& callbacks->memory[program_counter + 1] == opcode_byte)
+	{
+		/* Skip as many iterations as possible, leaving at least one to be done properly. */
+		const cc_u32f iterations = SkipBlockInstructionIterations(z80, callbacks, opcode, (cycles_available - z80->state->cycles - 1) / iteration_cycles);
+
+		z80->state->cycles += iterations * iteration_cycles;
+		IncrementRRegister(z80, iterations * 2);
+
+		/* Re-fetch the instruction. */
+		z80->state->run_cycles = run_cycles + z80->state->cycles;
+		z80->state->program_counter = program_counter + 2;
+		z80->state->cycles += 4 * 2;
+		IncrementRRegister(z80, 2);
+
+		ExecuteInstruction(z80, callbacks, instruction);
+	}
+}
+
+/* Returns whether the instruction (or an interrupt) caused execution to branch. */
+static cc_bool DoInstruction(const Z80* const z80, const Z80_ReadAndWriteCallbacks* const callbacks, const cc_u32f cycles_available)
 {
 	/* Process new instruction. */
 	Z80Instruction instruction;
+	cc_u16f next_program_counter;
+	cc_bool interruptible;
 
 #ifndef Z80_PRECOMPUTE_INSTRUCTION_METADATA
 	Z80_InstructionMetadata metadata;
 	instruction.metadata = &metadata;
 #endif
 
-	z80->state->cycles = 0;
+	if (z80->state->halted)
+	{
+		/* A halted CPU does nothing but execute 'NOP's until it is interrupted. */
+		z80->state->cycles = 4;
+		IncrementRRegister(z80, 1);
+
+		next_program_counter = z80->state->program_counter;
+		interruptible = cc_true;
+	}
+	else
+	{
+		z80->state->cycles = 0;
+
+		DecodeInstruction(z80, callbacks, &instruction);
+
+		next_program_counter = z80->state->program_counter;
 
-	DecodeInstruction(z80, callbacks, &instruction);
+		ExecuteInstruction(z80, callbacks, &instruction);
 
-	ExecuteInstruction(z80, callbacks, &instruction);
+		if (z80->state->program_counter != next_program_counter && !(z80->state->interrupt_pending && z80->state->interrupts_enabled))
+			RepeatBlockInstruction(z80, callbacks, &instruction, cycles_available);
+
+		/* Interrupts should not be able to occur directly after a prefix instruction.
+		   Curiously, interrupts do not occur directly after 'EI' instructions either. */
+		interruptible = instruction.metadata->opcode != Z80_OPCODE_DD_PREFIX
+			&& instruction.metadata->opcode != Z80_OPCODE_FD_PREFIX
+			&& instruction.metadata->opcode != Z80_OPCODE_EI;
+	}
 
 	/* Perform interrupt after processing the instruction. */
 	/* TODO: The other interrupt modes. */
-	if (z80->state->interrupt_pending
-		&& z80->state->interrupts_enabled
-		/* Interrupts should not be able to occur directly after a prefix instruction. */
-		&& instruction.metadata->opcode != Z80_OPCODE_DD_PREFIX
-		&& instruction.metadata->opcode != Z80_OPCODE_FD_PREFIX
-		/* Curiously, interrupts do not occur directly after 'EI' instructions either. */
-		&& instruction.metadata->opcode != Z80_OPCODE_EI)
+	if (z80->state->interrupt_pending && z80->state->interrupts_enabled && interruptible)
 	{
 		z80->state->interrupts_enabled = cc_false;
 		z80->state->interrupt_pending = cc_false;
+		z80->state->halted = cc_false;
 
 		/* TODO: Interrupt duration. */
 		--z80->state->stack_pointer;
@@ -2558,5 +2838,96 @@ cc_u16f Z80_DoCycle(const Z80* const z80, const Z80_ReadAndWriteCallbacks* const
 		z80->state->program_counter = 0x38;
 	}
 
+	return z80->state->program_counter != next_program_counter;
+}
+
+cc_u16f Z80_DoCycle(const Z80* const z80, const Z80_ReadAndWriteCallbacks* const callbacks)
+{
+	z80->state->run_cycles = 0;
+
+	DoInstruction(z80, callbacks, 0);
+
 	return z80->state->cycles;
 }
+
+cc_u32f Z80_Run(const Z80* const z80, const Z80_ReadAndWriteCallbacks* const callbacks, const cc_u32f cycle_budget)
+{
+	cc_u32f cycles_done = 0;
+	cc_bool branched;
+
+	do
+	{
+		z80->state->run_cycles = cycles_done;
+
+		if (z80->state->halted && !(z80->state->interrupt_pending && z80->state->interrupts_enabled))
+		{
+			/* Nothing can wake the CPU during the run, so skip straight to the end of it. */
+			const cc_u32f nops = CC_DIVIDE_CEILING(cycle_budget - cycles_done, 4);
+
+			IncrementRRegister(z80, nops);
+			cycles_done += nops * 4;
+			break;
+		}
+
+		branched = DoInstruction(z80, callbacks, cycle_budget - cycles_done);
+
+		cycles_done += z80->state->cycles;
+	} while (cycles_done < cycle_budget && !branched);
+
+	return cycles_done;
+}
+
+cc_u8f Z80_GetFlags(const Z80_State* const state)
+{
+	const cc_u16f source_value = state->flags_source;
+	const cc_u16f destination_value = state->flags_destination;
+	const cc_u16f result_value = state->flags_result & 0xFF;
+
+	cc_u8f flags;
+
+	if (state->flags_operation == FLAGS_OPERATION_NONE)
+		return state->f;
+
+	flags = GetDeferredSignZeroCarryFlags(state);
+
+	switch (state->flags_operation)
+	{
+		case FLAGS_OPERATION_ADD:
+		case FLAGS_OPERATION_SUBTRACT:
+			flags |= ((source_value ^ destination_value ^ result_value) >> (4 - FLAG_BIT_HALF_CARRY)) & FLAG_MASK_HALF_CARRY;
+			flags |= ((~(source_value ^ destination_value) & (source_value ^ result_value)) >> (7 - FLAG_BIT_PARITY_OVERFLOW)) & FLAG_MASK_PARITY_OVERFLOW;
+
+			if (state->flags_operation == FLAGS_OPERATION_SUBTRACT)
+			{
+				flags ^= FLAG_MASK_HALF_CARRY;
+				flags |= FLAG_MASK_ADD_SUBTRACT;
+			}
+
+			break;
+
+		case FLAGS_OPERATION_AND:
+			flags |= FLAG_MASK_HALF_CARRY;
+			/* Fallthrough */
+		case FLAGS_OPERATION_OR:
+			flags |= GetParityFlag(result_value);
+			break;
+	}
+
+	return flags;
+}
+
+cc_bool Z80_StatesMatch(const Z80_State* const state1, const Z80_State* const state2)
+{
+	return state1->register_mode == state2->register_mode
+		&& state1->program_counter == state2->program_counter
+		&& state1->stack_pointer == state2->stack_pointer
+		&& state1->a == state2->a && Z80_GetFlags(state1) == Z80_GetFlags(state2)
+		&& state1->bc == state2->bc && state1->de == state2->de && state1->hl == state2->hl
+		&& state1->a_ == state2->a_ && state1->f_ == state2->f_
+		&& state1->bc_ == state2->bc_ && state1->de_ == state2->de_ && state1->hl_ == state2->hl_
+		&& state1->ix == state2->ix && state1->iy == state2->iy
+		&& state1->i == state2->i
+		&& state1->interrupts_enabled == state2->interrupts_enabled
+		&& state1->interrupt_pending == state2->interrupt_pending
+		&& state1->halted == state2->halted;
+}
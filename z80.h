@@ -162,6 +162,7 @@ typedef struct Z80_InstructionMetadata
 	cc_u8l operands[2]; /* Z80_Operand */
 	cc_u8l condition;   /* Z80_Condition */
 	cc_u8l embedded_literal;
+	cc_u8l handler;     /* Internal: either the opcode or one of its operand-specialised variants. */
 	cc_bool has_displacement;
 } Z80_InstructionMetadata;
 
@@ -181,12 +182,20 @@ typedef struct Z80_State
 	cc_u16l cycles;
 	cc_u16l program_counter;
 	cc_u16l stack_pointer;
-	cc_u8l a, f, b, c, d, e, h, l;
-	cc_u8l a_, f_, b_, c_, d_, e_, h_, l_; /* Backup registers. */
-	cc_u8l ixh, ixl, iyh, iyl;
+	cc_u8l a, f; /* 'f' may be out of date: use 'Z80_GetFlags' to read it. */
+	cc_u16l bc, de, hl; /* Register pairs are stored whole, since they are mostly used as such. */
+	cc_u8l a_, f_; /* Backup registers. */
+	cc_u16l bc_, de_, hl_;
+	cc_u16l ix, iy;
 	cc_u8l r, i;
 	cc_bool interrupts_enabled;
 	cc_bool interrupt_pending;
+	cc_bool halted;
+	/* Internal: the flags of the most common ALU instructions are only calculated when something needs them. */
+	cc_u8l flags_operation;
+	cc_u8l flags_source, flags_destination;
+	cc_u16l flags_result;
+	cc_u16l run_cycles; /* How far into the current 'Z80_Run' call the current instruction began. For use by the callbacks. */
 } Z80_State;
 
 typedef struct Z80_ReadAndWriteCallbacks
@@ -194,6 +203,12 @@ typedef struct Z80_ReadAndWriteCallbacks
 	cc_u16f (*read)(const void *user_data, cc_u16f address);
 	void (*write)(const void *user_data, cc_u16f address, cc_u16f value);
 	const void *user_data;
+	/* Optional: instruction fetches and block transfers (LDIR and friends) at addresses below 'memory_size'
+	   access 'memory' directly instead of going through 'read' and 'write'. This must only cover plain RAM, with
+	   no side-effects for reads or writes. The first iteration of a block transfer always goes through the
+	   callbacks. Set 'memory_size' to 0 to disable this. */
+	cc_u8l *memory;
+	cc_u16f memory_size;
 } Z80_ReadAndWriteCallbacks;
 
 typedef struct Z80
@@ -207,5 +222,12 @@ void Z80_State_Initialise(Z80_State *state);
 void Z80_Reset(const Z80 *z80);
 void Z80_Interrupt(const Z80 *z80, cc_bool assert_interrupt);
 cc_u16f Z80_DoCycle(const Z80 *z80, const Z80_ReadAndWriteCallbacks *callbacks);
+/* Executes a run of straight-line code, stopping once at least 'cycle_budget' cycles have been done, or after an
+   instruction (or interrupt) causes execution to branch. At least one instruction is always executed.
+   'cycle_budget' must not exceed 0xFFFF. Returns the number of cycles done. */
+cc_u32f Z80_Run(const Z80 *z80, const Z80_ReadAndWriteCallbacks *callbacks, cc_u32f cycle_budget);
+cc_u8f Z80_GetFlags(const Z80_State *state);
+/* Compares two states, ignoring the 'R' register and the cycle counters. */
+cc_bool Z80_StatesMatch(const Z80_State *state1, const Z80_State *state2);
 
 #endif /* Z80_H */